@@ -20,6 +20,8 @@
 #include <sys/stat.h>  /* for S_IRWXU */
 #include <unistd.h>
 
+#include "util-sig-trace.h"
+
 /*
  * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
  *
@@ -38,6 +40,18 @@ static volatile sig_atomic_t  stop_sig = 0;
 static volatile sig_atomic_t  act_sig = 0;
 static volatile unsigned long  num_acts = 0;
 
+/*
+ * Trace mode: the handlers also append each signal to the trace ring
+ * (see util-sig-trace.h), dumped by the loop when it notices a signal.
+ */
+static int  want_trace = 0;
+
+void
+enable_loop_err_trace (void)
+{
+    want_trace = 1;
+}
+
 unsigned long
 get_num_acts (void)
 {
@@ -54,6 +68,9 @@ static void
 act_fail_handler_1arg (int signo)
 {
     act_sig = signo;
+    if (want_trace) {
+        ust_record(signo, NULL);
+    }
     close(-1);  /* should set errno to EBADF */
     ++num_acts;
 }
@@ -62,6 +79,9 @@ static void
 act_fail_handler_3args (int signo, siginfo_t *info, void *other)
 {
     act_sig = signo;
+    if (want_trace) {
+        ust_record(signo, info);
+    }
     close(-1);  /* should set errno to EBADF */
     ++num_acts;
 }
@@ -148,9 +168,16 @@ loop_expecting_eacces (const char *message_preamble)
 
         if (act_sig_copy != 0) {
             ++num_sig_detected;
+            if (want_trace) {
+                ust_dump(message_preamble, stdout);
+            }
         }
     }
 
+    if (want_trace) {
+        ust_dump(message_preamble, stdout);
+    }
+
     printf("\n%s Stopped by signal %d after"
            "\n%s  %lu calls made,"
            "\n%s  %lu signals with interfering action detected,"
@@ -161,6 +188,35 @@ loop_expecting_eacces (const char *message_preamble)
            message_preamble, num_unexpected);
 }
 
+unsigned long
+calls_expecting_eacces (unsigned long max_calls, unsigned long *num_calls)
+{
+    unsigned long  ix;
+    unsigned long  num_unexpected = 0;
+
+    int      my_res;
+    errno_t  my_err;
+
+    for (ix = 0; ix < max_calls && stop_sig == 0; ++ix) {
+        /* Same call as in loop_expecting_eacces() above. */
+        errno = 0;
+        my_res = mkdir("/should-fail", S_IRWXU);
+        my_err = errno;
+
+        if (my_res != -1) {
+            fprintf(stderr, "Unexpected return value %d from mkdir()\n", my_res);
+            exit(9);
+        }
+        if (my_err != EACCES) {
+            ++num_unexpected;
+        }
+    }
+
+    *num_calls += ix;
+
+    return num_unexpected;
+}
+
 
 void
 register_loop_err_sigactions (int sigaction_flags)
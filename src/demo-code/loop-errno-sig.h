@@ -14,9 +14,22 @@
 
 unsigned long  get_num_acts(void);
 
+/*
+ * The handlers append each signal to the trace ring (see util-sig-trace.h),
+ * which loop_expecting_eacces() dumps when it notices a signal.
+ */
+void  enable_loop_err_trace(void);
+
 void  test_close_ebadf(void);
 void  loop_expecting_eacces(const char *message_preamble);
 
+/*
+ * Bounded and quiet variant, for tasks: makes at most 'max_calls' calls
+ * (fewer if a stop signal arrives), adds the number of calls made
+ * to '*num_calls'.  Returns the number of unexpected errno values.
+ */
+unsigned long  calls_expecting_eacces(unsigned long max_calls, unsigned long *num_calls);
+
 void  register_loop_err_sigactions(int sigaction_flags);
 
 void  get_loop_err_sigset(sigset_t *out);
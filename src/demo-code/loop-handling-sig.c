@@ -18,9 +18,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/select.h>
+#include <sys/signalfd.h>
 #include <unistd.h>
 
+#include "util-async-log.h"
+#include "util-latency.h"
+#include "util-sig-trace.h"
 #include "util-timespec.h"
 #include "util-timeval.h"
 
@@ -40,17 +45,78 @@
 
 static int  want_compact_info = 0;
 
+/*
+ * Latency mode: every signal queued with sigqueue() is expected to carry
+ * its send time in 'sival_int' (see ulat_stamp32(), used by
+ * 'za-rtsig-send stamp'); we collect the delivery latencies in histograms
+ * and skip the per-signal messages, which would distort the measurement.
+ */
+static int  want_latency_stats = 0;
+
+void
+enable_loop_handlesig_latency_stats (void)
+{
+    want_latency_stats = 1;
+}
+
+/*
+ * ... unless the per-signal messages are wanted anyway, to measure
+ * what they cost: with stdio, or queued to the async log
+ * (see util-async-log.h) if it was started.
+ */
+static int  want_messages = 0;
+
+void
+enable_loop_handlesig_messages (void)
+{
+    want_messages = 1;
+}
+
+/*
+ * Trace mode: the handlers append each signal to the trace ring
+ * (see util-sig-trace.h), and the loops dump the ring after each wakeup.
+ */
+static int  want_trace = 0;
+
+void
+enable_loop_handlesig_trace (void)
+{
+    want_trace = 1;
+}
+
 
 static volatile sig_atomic_t  stop_sig = 0;
 static volatile sig_atomic_t  act_sig = 0;
 static volatile unsigned long  num_handled_async = 0;
 
+/*
+ * Updated only by act_handler_3args(); in latency mode the handler is
+ * registered with all our handled signals in 'sa_mask', so
+ * one invocation cannot interrupt another (in the same thread)
+ * halfway through updating the histogram.
+ */
+static ulat_hist  async_latency_hist;
+static volatile unsigned long  num_unstamped_async = 0;
+
 unsigned long
 get_num_handled_async (void)
 {
     return num_handled_async;
 }
 
+void
+show_async_latency_stats (const char *message_preamble, FILE *out_stream)
+{
+    char  hist_preamble[128];
+
+    snprintf(hist_preamble, sizeof hist_preamble,
+             "%s Async (handler) delivery latency:", message_preamble);
+    ulat_show_hist(&async_latency_hist, hist_preamble, out_stream);
+
+    fprintf(out_stream, "%s Handled asynchronously without a sigqueue() stamp: %lu.\n",
+            message_preamble, num_unstamped_async);
+}
+
 static void
 soft_stop_handler (int signo)
 {
@@ -62,6 +128,10 @@ act_handler_1arg (int signo)
 {
     act_sig = signo;
     ++num_handled_async;
+
+    if (want_trace) {
+        ust_record(signo, NULL);
+    }
 }
 
 static void
@@ -69,23 +139,60 @@ act_handler_3args (int signo, siginfo_t *info, void *other)
 {
     act_sig = signo;
     ++num_handled_async;
+
+    if (want_trace) {
+        ust_record(signo, info);
+    }
+
+    if (want_latency_stats) {
+        if (SI_QUEUE == info->si_code) {
+            ulat_hist_add(&async_latency_hist,
+                          ulat_stamp32_age_ns((uint32_t) info->si_value.sival_int));
+        } else {
+            ++num_unstamped_async;
+        }
+    }
 }
 
 
 static void
 show_siginfo (const char *message_preamble, const siginfo_t *siginfo)
 {
-    printf("%s   si_signo=%d, si_code=%d, si_errno=%d;\n"
-           "%s   Sending process: si_pid=%d, si_uid=%d;\n"
-           "%s   si_status=%d, si_value.sival_int=%d.\n",
-           message_preamble,
-           siginfo->si_signo, siginfo->si_code, siginfo->si_errno,
-           message_preamble, siginfo->si_pid, siginfo->si_uid,
-           message_preamble, siginfo->si_status, siginfo->si_value.sival_int);
+    UALOG_PRINTF("%s   si_signo=%d, si_code=%d, si_errno=%d;\n"
+                 "%s   Sending process: si_pid=%d, si_uid=%d;\n"
+                 "%s   si_status=%d, si_value.sival_int=%d.\n",
+                 message_preamble,
+                 siginfo->si_signo, siginfo->si_code, siginfo->si_errno,
+                 message_preamble, siginfo->si_pid, siginfo->si_uid,
+                 message_preamble, siginfo->si_status, siginfo->si_value.sival_int);
+}
+
+/*
+ * Cost per received signal, shown by both synchronous engines so they can
+ * be compared: sigtimedwait() takes one syscall for each signal, while
+ * a single read() from a signalfd can return a whole batch.
+ */
+static void
+show_receive_rate_ (const char *message_preamble, const char *syscalls_desc,
+                    unsigned long num_signals, unsigned long num_syscalls,
+                    unsigned long long first_ns, unsigned long long last_ns)
+{
+    printf("%s Received %lu signals with %lu syscalls (%s)",
+           message_preamble, num_signals, num_syscalls, syscalls_desc);
+    if (num_syscalls > 0) {
+        printf(": %.3f signals per syscall", (double) num_signals / num_syscalls);
+    }
+    if (num_signals > 1 && last_ns > first_ns) {
+        printf(",\n%s  %.0f signals/s between the first and the last one",
+               message_preamble,
+               (double) (num_signals - 1) * 1e9 / (double) (last_ns - first_ns));
+    }
+    printf(".\n");
 }
 
 void
-loop_waiting_signal (const char *message_preamble, double cycle_time_s)
+loop_waiting_signal (const char *message_preamble, double cycle_time_s,
+                     ucnt_block *counters)
 {
     struct timespec  cycle_tspec;
 
@@ -100,9 +207,19 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
     unsigned long  num_intr = 0;
     unsigned long  num_fail = 0;
 
+    ulat_hist  sync_latency_hist;  /* local: this loop may run in many threads */
+    char       hist_preamble[128];
+
+    unsigned long  num_unstamped = 0;
+
+    unsigned long long  first_ns = 0;
+    unsigned long long  last_ns = 0;
+
     int      swait_res;
     errno_t  swait_err;
 
+    ulat_hist_reset(&sync_latency_hist);
+
     get_loop_handlesig_sigset(&sigset);
 
     fill_timespec_from_double(&cycle_tspec, cycle_time_s);
@@ -110,26 +227,50 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
     fprintf(stdout, "%s Cycle time: ", message_preamble);
     show_timespec(&cycle_tspec, stdout);
     fprintf(stdout, ".\n");
+    ualog_flush();  /* the messages in the loop may go to the async log */
 
     while (stop_sig == 0) {
         errno = 0;
         swait_res = sigtimedwait(&sigset, &siginfo, &cycle_tspec);
         swait_err = errno;
         ++num_cycles;
+        ucnt_inc(counters, UCNT_CYCLES);
+
+        if (want_trace) {  /* signals handled asynchronously meanwhile, if any */
+            ust_dump(message_preamble, stdout);
+        }
 
         if (swait_res > 0) {
+            last_ns = ulat_now_ns();
+            if (0 == num_sync) {
+                first_ns = last_ns;
+            }
             ++num_sync;
+            ucnt_inc(counters, UCNT_EVENTS);
 
-            printf("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
-                   " Synchronously handling signal %d:",
-                   message_preamble, num_cycles, num_sync, num_intr, num_fail,
-                   swait_res);
+            if (want_latency_stats) {
+                if (SI_QUEUE == siginfo.si_code) {
+                    ulat_hist_add(&sync_latency_hist,
+                                  ulat_stamp32_age_ns((uint32_t) siginfo.si_value.sival_int));
+                } else {
+                    ++num_unstamped;
+                }
+            }
+            if ((want_latency_stats && !want_messages) || counters != NULL) {
+                continue;  /* quiet: no stdio on the hot path */
+            }
 
+            /* One call per line: each becomes one async log record. */
             if (want_compact_info) {
-                printf(" sival_int = %d\n",
-                       siginfo.si_value.sival_int);
+                UALOG_PRINTF("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
+                             " Synchronously handling signal %d: sival_int = %d\n",
+                             message_preamble, num_cycles, num_sync, num_intr, num_fail,
+                             swait_res, siginfo.si_value.sival_int);
             } else {
-                printf("\n");
+                UALOG_PRINTF("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
+                             " Synchronously handling signal %d:\n",
+                             message_preamble, num_cycles, num_sync, num_intr, num_fail,
+                             swait_res);
                 show_siginfo(message_preamble, &siginfo);
                 want_compact_info = 1;
             }
@@ -140,16 +281,22 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
                 /* TODO: maybe print a progress message (one dot per cycle?) */
             } else if (EINTR == swait_err) {
                 if (stop_sig != 0) {
-                    fprintf(stderr, "%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
-                            " sigtimedwait() interrupted (probably signal %d): errno %d.\n",
-                            message_preamble, num_cycles, num_sync, num_intr, num_fail,
-                            stop_sig, swait_err);
+                    UALOG_EPRINTF("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
+                                  " sigtimedwait() interrupted (probably signal %d): errno %d.\n",
+                                  message_preamble, num_cycles, num_sync, num_intr, num_fail,
+                                  (int) stop_sig, swait_err);
                 } else {
                     ++num_intr;
-                    fprintf(stderr, "%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
-                            " sigtimedwait() unexpectedly interrupted: errno %d.\n",
-                            message_preamble, num_cycles, num_sync, num_intr, num_fail,
-                            swait_err);
+                    ucnt_inc(counters, UCNT_INTR);
+                    /* Happens often with several threads waiting: another one
+                     * may dequeue the signal that woke us.  Quiet if counting.
+                     */
+                    if (NULL == counters) {
+                        UALOG_EPRINTF("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
+                                      " sigtimedwait() unexpectedly interrupted: errno %d.\n",
+                                      message_preamble, num_cycles, num_sync, num_intr, num_fail,
+                                      swait_err);
+                    }
                 }
             } else if (EINVAL == swait_err) {
                 /*
@@ -169,6 +316,7 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
                 exit(91);
             } else {
                 ++num_fail;
+                ucnt_inc(counters, UCNT_FAIL);
 
                 res = strerror_r(swait_err, err_buf, sizeof err_buf);
                 if (res != 0) {
@@ -179,14 +327,19 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
                     exit(98);
                 }
 
-                fprintf(stderr, "%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
-                        " Unexpected errno %d from sigtimedwait(): %s\n",
-                        message_preamble, num_cycles, num_sync, num_intr, num_fail,
-                        swait_err, err_buf);
+                UALOG_EPRINTF("%s [%lu cycles: %lu sync, %lu intr, %lu fail]"
+                              " Unexpected errno %d from sigtimedwait(): %s\n",
+                              message_preamble, num_cycles, num_sync, num_intr, num_fail,
+                              swait_err, err_buf);
             }
         }
     }
 
+    ualog_flush();
+    if (want_trace) {
+        ust_dump(message_preamble, stdout);
+    }
+
     printf("\n%s Waiting loop stopped by signal %d after"
            "\n%s  %lu cycles,"
            "\n%s  %lu signals handled synchronously,"
@@ -197,11 +350,284 @@ loop_waiting_signal (const char *message_preamble, double cycle_time_s)
            message_preamble, num_sync,
            message_preamble, num_intr,
            message_preamble, num_fail);
+
+    show_receive_rate_(message_preamble, "sigtimedwait",
+                       num_sync, num_cycles, first_ns, last_ns);
+
+    if (want_latency_stats) {
+        snprintf(hist_preamble, sizeof hist_preamble,
+                 "%s Sync (sigtimedwait) delivery latency:", message_preamble);
+        ulat_show_hist(&sync_latency_hist, hist_preamble, stdout);
+
+        printf("%s Handled synchronously without a sigqueue() stamp: %lu.\n",
+               message_preamble, num_unstamped);
+    }
+}
+
+
+static void
+show_signalfd_siginfo (const char *message_preamble,
+                       const struct signalfd_siginfo *sfd_info)
+{
+    UALOG_PRINTF("%s   ssi_signo=%u, ssi_code=%d, ssi_errno=%d;\n"
+                 "%s   Sending process: ssi_pid=%u, ssi_uid=%u;\n"
+                 "%s   ssi_status=%d, ssi_int=%d.\n",
+                 message_preamble,
+                 sfd_info->ssi_signo, sfd_info->ssi_code, sfd_info->ssi_errno,
+                 message_preamble, sfd_info->ssi_pid, sfd_info->ssi_uid,
+                 message_preamble, sfd_info->ssi_status, sfd_info->ssi_int);
+}
+
+/*
+ * Max number of records returned by one read() from the signalfd.
+ * 64 records of 128 bytes each: 8 KBytes on the stack.
+ */
+#define SIGNALFD_BATCH_MAX  64
+
+void
+loop_reading_signalfd (const char *message_preamble, double cycle_time_s,
+                       ucnt_block *counters)
+{
+    struct signalfd_siginfo  sfd_infos[SIGNALFD_BATCH_MAX];
+    struct epoll_event  ev;
+
+    sigset_t  sigset;
+    int  sfd;
+    int  epfd;
+    int  timeout_ms;
+
+    char  err_buf[128];
+    int   res;
+
+    unsigned long  num_cycles = 0;  /* epoll_wait() calls */
+    unsigned long  num_reads = 0;
+    unsigned long  num_signals = 0;
+    unsigned long  max_batch = 0;
+    unsigned long  num_intr = 0;
+    unsigned long  num_fail = 0;
+
+    ulat_hist  sfd_latency_hist;  /* local: this loop may run in many threads */
+    char       hist_preamble[128];
+
+    unsigned long  num_unstamped = 0;
+
+    unsigned long long  first_ns = 0;
+    unsigned long long  last_ns = 0;
+
+    int      ep_res;
+    errno_t  ep_err;
+
+    ssize_t  num_read;
+    errno_t  read_err;
+    unsigned long  batch;
+    unsigned long  ix;
+
+    ulat_hist_reset(&sfd_latency_hist);
+
+    get_loop_handlesig_sigset(&sigset);
+
+    /*
+     * Non-blocking: we keep reading until a short read (or EAGAIN),
+     * and a read that finds nothing must not block the loop ---
+     * the stop signals are checked only after epoll_wait().
+     */
+    sfd = signalfd(-1, &sigset, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0) {
+        perror("signalfd");
+        exit(92);
+    }
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        exit(93);
+    }
+
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = sfd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, sfd, &ev) < 0) {
+        perror("epoll_ctl(EPOLL_CTL_ADD, signalfd)");
+        exit(94);
+    }
+
+    if (cycle_time_s >= 2000000.0) {  /* would overflow an int in milliseconds */
+        timeout_ms = -1;
+    } else {
+        timeout_ms = (int) (cycle_time_s * 1000.0);
+        if (0 == timeout_ms && cycle_time_s > 0.0) {
+            timeout_ms = 1;  /* epoll_wait() cannot wait less */
+        }
+    }
+
+    fprintf(stdout, "%s Cycle time: %d ms (signalfd %d, epoll %d, up to %d records per read).\n",
+            message_preamble, timeout_ms, sfd, epfd, SIGNALFD_BATCH_MAX);
+    ualog_flush();  /* the messages in the loop may go to the async log */
+
+    while (stop_sig == 0) {
+        errno = 0;
+        ep_res = epoll_wait(epfd, &ev, 1, timeout_ms);
+        ep_err = errno;
+        ++num_cycles;
+        ucnt_inc(counters, UCNT_CYCLES);
+
+        if (ep_res == 0) {  /* timeout */
+            continue;
+        }
+
+        if (ep_res < 0) {
+            if (EINTR == ep_err) {
+                if (stop_sig != 0) {
+                    UALOG_EPRINTF("%s [%lu cycles: %lu signals, %lu intr, %lu fail]"
+                                  " epoll_wait() interrupted (probably signal %d): errno %d.\n",
+                                  message_preamble, num_cycles, num_signals, num_intr, num_fail,
+                                  (int) stop_sig, ep_err);
+                } else {
+                    ++num_intr;
+                    ucnt_inc(counters, UCNT_INTR);
+                    if (NULL == counters) {
+                        UALOG_EPRINTF("%s [%lu cycles: %lu signals, %lu intr, %lu fail]"
+                                      " epoll_wait() unexpectedly interrupted: errno %d.\n",
+                                      message_preamble, num_cycles, num_signals, num_intr, num_fail,
+                                      ep_err);
+                    }
+                }
+            } else {
+                /*
+                 * EBADF, EFAULT or EINVAL: a bug in this function;
+                 * retrying with the same arguments cannot help.
+                 */
+                fprintf(stderr, "%s [%lu cycles: %lu signals, %lu intr, %lu fail]"
+                        " Unexpected errno %d from epoll_wait().\n",
+                        message_preamble, num_cycles, num_signals, num_intr, num_fail,
+                        ep_err);
+                exit(95);
+            }
+            continue;
+        }
+
+        /*
+         * Drain the queue: each read() returns as many records as
+         * are pending, up to SIGNALFD_BATCH_MAX.  A short read means
+         * the queue was empty at that moment, so we can skip
+         * the extra read() that would only return EAGAIN.
+         */
+        do {
+            errno = 0;
+            num_read = read(sfd, sfd_infos, sizeof sfd_infos);
+            read_err = errno;
+            ++num_reads;
+
+            if (num_read < 0) {
+                if (EAGAIN == read_err) {
+                    break;
+                }
+                if (EINTR == read_err) {  /* cannot really happen: non-blocking */
+                    ++num_intr;
+                    ucnt_inc(counters, UCNT_INTR);
+                    break;
+                }
+
+                ++num_fail;
+                ucnt_inc(counters, UCNT_FAIL);
+
+                res = strerror_r(read_err, err_buf, sizeof err_buf);
+                if (res != 0) {
+                    fprintf(stderr, "%s [%lu cycles: %lu signals, %lu intr, %lu fail]"
+                            " strerror_r(%d) failed, returning the errno value %d.\n",
+                            message_preamble, num_cycles, num_signals, num_intr, num_fail,
+                            read_err, res);
+                    exit(97);
+                }
+
+                UALOG_EPRINTF("%s [%lu cycles: %lu signals, %lu intr, %lu fail]"
+                              " Unexpected errno %d from read(signalfd): %s\n",
+                              message_preamble, num_cycles, num_signals, num_intr, num_fail,
+                              read_err, err_buf);
+                break;
+            }
+
+            batch = (unsigned long) num_read / sizeof sfd_infos[0];
+            if (0 == batch) {
+                break;
+            }
+
+            last_ns = ulat_now_ns();
+            if (0 == num_signals) {
+                first_ns = last_ns;
+            }
+            num_signals += batch;
+            ucnt_add(counters, UCNT_EVENTS, batch);
+            if (batch > max_batch) {
+                max_batch = batch;
+            }
+
+            for (ix = 0; ix < batch; ++ix) {
+                if (want_latency_stats) {
+                    if (SI_QUEUE == sfd_infos[ix].ssi_code) {
+                        ulat_hist_add(&sfd_latency_hist,
+                                      ulat_stamp32_age_ns((uint32_t) sfd_infos[ix].ssi_int));
+                    } else {
+                        ++num_unstamped;
+                    }
+                }
+                if ((want_latency_stats && !want_messages) || counters != NULL) {
+                    continue;  /* quiet: no stdio on the hot path */
+                }
+
+                if (want_compact_info) {
+                    UALOG_PRINTF("%s [%lu cycles: %lu reads, %lu signals] Read signal %u"
+                                 " (%lu of %lu in this batch): ssi_int = %d\n",
+                                 message_preamble, num_cycles, num_reads, num_signals,
+                                 sfd_infos[ix].ssi_signo, ix + 1, batch,
+                                 sfd_infos[ix].ssi_int);
+                } else {
+                    UALOG_PRINTF("%s [%lu cycles: %lu reads, %lu signals] Read signal %u"
+                                 " (%lu of %lu in this batch):\n",
+                                 message_preamble, num_cycles, num_reads, num_signals,
+                                 sfd_infos[ix].ssi_signo, ix + 1, batch);
+                    show_signalfd_siginfo(message_preamble, &sfd_infos[ix]);
+                    want_compact_info = 1;
+                }
+            }
+        } while (batch == SIGNALFD_BATCH_MAX);
+    }
+
+    close(epfd);
+    close(sfd);
+
+    ualog_flush();
+
+    printf("\n%s Signalfd loop stopped by signal %d after"
+           "\n%s  %lu cycles (epoll_wait() calls),"
+           "\n%s  %lu reads from the signalfd,"
+           "\n%s  %lu signals read (at most %lu in one read),"
+           "\n%s  %lu times epoll_wait() was unexpectedly interrupted,"
+           "\n%s  %lu failures.\n",
+           message_preamble, (int) stop_sig,
+           message_preamble, num_cycles,
+           message_preamble, num_reads,
+           message_preamble, num_signals, max_batch,
+           message_preamble, num_intr,
+           message_preamble, num_fail);
+
+    show_receive_rate_(message_preamble, "epoll_wait + read",
+                       num_signals, num_cycles + num_reads, first_ns, last_ns);
+
+    if (want_latency_stats) {
+        snprintf(hist_preamble, sizeof hist_preamble,
+                 "%s Sync (signalfd) delivery latency:", message_preamble);
+        ulat_show_hist(&sfd_latency_hist, hist_preamble, stdout);
+
+        printf("%s Read from the signalfd without a sigqueue() stamp: %lu.\n",
+               message_preamble, num_unstamped);
+    }
 }
 
 
 void
-loop_sleeping (const char *message_preamble, double cycle_time_s)
+loop_sleeping (const char *message_preamble, double cycle_time_s,
+               ucnt_block *counters)
 {
     struct timeval  cycle_tval;
 
@@ -230,6 +656,7 @@ loop_sleeping (const char *message_preamble, double cycle_time_s)
     fprintf(stdout, "%s Cycle time: ", message_preamble);
     show_timeval(&cycle_tval, stdout);
     fprintf(stdout, ".\n");
+    ualog_flush();  /* the messages in the loop may go to the async log */
 
     while (stop_sig == 0) {
         tval = cycle_tval;
@@ -237,6 +664,11 @@ loop_sleeping (const char *message_preamble, double cycle_time_s)
         sel_res = select(0, NULL, NULL, NULL, &tval);  /* sleep */
         sel_err = errno;
         ++num_cycles;
+        ucnt_inc(counters, UCNT_CYCLES);
+
+        if (want_trace) {
+            ust_dump(message_preamble, stdout);
+        }
 
         if (sel_res == 0) {  /* timeout */
             /* TODO: maybe print a progress message (one dot per cycle?) */
@@ -253,16 +685,22 @@ loop_sleeping (const char *message_preamble, double cycle_time_s)
 
             if (EINTR == sel_err) {
                 if (stop_sig != 0) {
-                    fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                            " select() interrupted (probably signal %d): errno %d = %s\n",
-                            message_preamble, num_cycles, num_intr, num_fail,
-                            stop_sig, sel_err, err_buf);
+                    UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                                  " select() interrupted (probably signal %d): errno %d = %s\n",
+                                  message_preamble, num_cycles, num_intr, num_fail,
+                                  (int) stop_sig, sel_err, err_buf);
                 } else {
                     ++num_intr;
-                    fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                            " select() unexpectedly interrupted: errno %d = %s\n",
-                            message_preamble, num_cycles, num_intr, num_fail,
-                            sel_err, err_buf);
+                    ucnt_inc(counters, UCNT_INTR);
+                    /* In latency mode every handled signal interrupts us;
+                     * a message for each would delay the next handler.
+                     */
+                    if ((!want_latency_stats || want_messages) && NULL == counters) {
+                        UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                                      " select() unexpectedly interrupted: errno %d = %s\n",
+                                      message_preamble, num_cycles, num_intr, num_fail,
+                                      sel_err, err_buf);
+                    }
                 }
             } else if (EINVAL == sel_err) {
                 /*
@@ -279,13 +717,19 @@ loop_sleeping (const char *message_preamble, double cycle_time_s)
                 exit(90);
             } else {
                 ++num_fail;
-                fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                        " Unexpected errno %d from select(): %s\n",
-                        message_preamble, num_cycles, num_intr, num_fail, sel_err, err_buf);
+                ucnt_inc(counters, UCNT_FAIL);
+                UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                              " Unexpected errno %d from select(): %s\n",
+                              message_preamble, num_cycles, num_intr, num_fail, sel_err, err_buf);
             }
         }
     }
 
+    ualog_flush();
+    if (want_trace) {
+        ust_dump(message_preamble, stdout);
+    }
+
     printf("\n%s Sleeping loop stopped by signal %d after"
            "\n%s  %lu cycles,"
            "\n%s  %lu times select() was unexpectedly interrupted,"
@@ -327,7 +771,11 @@ register_loop_handlesig_sigactions (int sigaction_flags)
         act.sa_handler = &act_handler_1arg;
     }
 
-    sigemptyset(&act.sa_mask);
+    if (want_latency_stats) {
+        get_loop_handlesig_sigset(&act.sa_mask);  /* see 'async_latency_hist' */
+    } else {
+        sigemptyset(&act.sa_mask);
+    }
     act.sa_flags = sigaction_flags;
 
     if (sigaction(SIGUSR1, &act, NULL) < 0) {
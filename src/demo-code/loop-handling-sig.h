@@ -11,14 +11,57 @@
  */
 
 #include <signal.h>
+#include <stdio.h>
+
+#include "util-counters.h"
 
 unsigned long  get_num_handled_async(void);
 
+/*
+ * Latency mode: expect signals sent by 'za-rtsig-send stamp' and
+ * collect delivery latency histograms instead of showing each signal.
+ * Must be called before register_loop_handlesig_sigactions();
+ * the asynchronous path needs SA_SIGINFO in the sigaction flags.
+ */
+void  enable_loop_handlesig_latency_stats(void);
+
+/*
+ * Show each signal (or interruption) even in latency mode, to measure
+ * what the messages cost; they go to the async log if it was started
+ * (see ualog_start()), else to stdio.
+ */
+void  enable_loop_handlesig_messages(void);
+
+/*
+ * The asynchronous handlers append each signal to the trace ring
+ * (see util-sig-trace.h); the waiting and sleeping loops dump it
+ * after each wakeup.  Works with the latency mode too.
+ */
+void  enable_loop_handlesig_trace(void);
+void  show_async_latency_stats(const char *message_preamble, FILE *out_stream);
+
 /*
  * Second arg ('cycle_time_s') is the Cycle Time in Seconds; decimals allowed.
+ *
+ * Third arg ('counters'): if NULL, each signal (or interruption) is shown
+ * as it happens; otherwise the loop is quiet and only updates the counters,
+ * to be shown by a reporter (see uex_start_reporter()) ---
+ * stdio takes a lock on each call, which would serialize the threads
+ * and dominate the measured cost.
+ */
+void  loop_waiting_signal(const char *message_preamble, double cycle_time_s,
+                          ucnt_block *counters);
+void  loop_sleeping(const char *message_preamble, double cycle_time_s,
+                    ucnt_block *counters);
+
+/*
+ * Reads batches of 'struct signalfd_siginfo' records from a signalfd,
+ * waiting for them with epoll_wait().  The handled signals
+ * (see get_loop_handlesig_sigset()) must be blocked in ALL threads,
+ * otherwise they get delivered to a handler instead of queued for reading.
  */
-void  loop_waiting_signal(const char *message_preamble, double cycle_time_s);
-void  loop_sleeping(const char *message_preamble, double cycle_time_s);
+void  loop_reading_signalfd(const char *message_preamble, double cycle_time_s,
+                            ucnt_block *counters);
 
 void  register_loop_handlesig_sigactions(int sigaction_flags);
 
@@ -0,0 +1,262 @@
+/*
+ * demo-code/loop-reading-splice.c
+ *
+ * splice() and tee() engine: moves the input to an output fd
+ * (e.g. /dev/null) without copying it into user memory, optionally
+ * duplicating it to a second fd on the way.
+ *
+ * splice() needs a pipe on one side, tee() on both: an input that is
+ * not a pipe goes through an intermediate pipe, and so does the data for
+ * a tee fd that is not a pipe.  The pages are moved (or referenced)
+ * between the pipe buffers and the files, never mapped in this process.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _GNU_SOURCE  /* for splice(), tee() and F_SETPIPE_SZ */
+
+#include "loop-reading.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+typedef struct {
+    int  sc_out_fd;
+
+    int  sc_tee_fd;      /* negative: no tee */
+    int  sc_tee_target;  /* where tee() writes: 'sc_tee_fd' or 'sc_tee_pipe[1]' */
+    int  sc_tee_pipe[2];
+
+    read_stats *sc_rs;
+} splice_ctx;
+
+
+static int
+is_pipe_ (int fd)
+{
+    struct stat  st;
+
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+/*
+ * Best effort: a pipe holds 64 KiB by default, which would limit
+ * each splice() into it, whatever the chunk size.
+ */
+static void
+make_pipe_ (int pipe_fds[2], size_t chunk)
+{
+    if (pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        pipe_fds[0] = pipe_fds[1] = -1;
+        return;
+    }
+    if (chunk <= (size_t) 1 << 30) {
+        (void) fcntl(pipe_fds[1], F_SETPIPE_SZ, (int) chunk);
+    }
+}
+
+static void
+close_pipe_ (int pipe_fds[2])
+{
+    if (pipe_fds[0] >= 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+}
+
+/*
+ * Moves exactly 'n' bytes, that are already in the pipe 'from_pipe'.
+ */
+static errno_t
+splice_all_ (int from_pipe, int to_fd, size_t n, read_stats *rs)
+{
+    ssize_t  num_moved;
+    errno_t  err;
+
+    while (n > 0) {
+        num_moved = splice(from_pipe, NULL, to_fd, NULL, n, SPLICE_F_MOVE);
+        ++rs->rs_syscalls;
+        if (num_moved < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            err = errno;
+            fprintf(stderr, "splice(%d -> %d) failed: errno %d = %s\n",
+                    from_pipe, to_fd, err, strerror(err));
+            return err;
+        }
+        if (0 == num_moved) {
+            fprintf(stderr, "splice(%d -> %d): pipe empty with %zu bytes to go\n",
+                    from_pipe, to_fd, n);
+            return EIO;
+        }
+        n -= (size_t) num_moved;
+    }
+
+    return 0;
+}
+
+/*
+ * Forwards up to 'max' bytes from the pipe 'src' to the output
+ * (and to the tee fd, if any).  If 'max' bytes are known to be in the pipe,
+ * forwards all of them; otherwise ('src' is the input) forwards what
+ * the first call returns.
+ * Returns the number of bytes forwarded (0 at EOF), or -1 with 'errno' set.
+ */
+static ssize_t
+forward_ (const splice_ctx *sc, int src, size_t max, int known_full)
+{
+    ssize_t  num_done = 0;
+    ssize_t  n;
+
+    errno_t  err;
+
+    for (;;) {
+        if (sc->sc_tee_fd < 0) {
+            n = splice(src, NULL, sc->sc_out_fd, NULL, max - (size_t) num_done,
+                       SPLICE_F_MOVE);
+        } else {
+            /* tee() does not consume, so splice out what was duplicated
+             * before the next tee(), that would duplicate it again. */
+            n = tee(src, sc->sc_tee_target, max - (size_t) num_done, 0);
+        }
+        ++sc->sc_rs->rs_syscalls;
+
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            err = errno;
+            fprintf(stderr, "%s(%d) failed: errno %d = %s\n",
+                    (sc->sc_tee_fd < 0) ? "splice" : "tee", src, err, strerror(err));
+            errno = err;
+            return -1;
+        }
+        if (0 == n) {
+            break;  /* EOF */
+        }
+
+        if (sc->sc_tee_fd >= 0) {
+            err = splice_all_(src, sc->sc_out_fd, (size_t) n, sc->sc_rs);
+            if (0 == err && sc->sc_tee_target != sc->sc_tee_fd) {
+                err = splice_all_(sc->sc_tee_pipe[0], sc->sc_tee_fd, (size_t) n, sc->sc_rs);
+            }
+            if (err != 0) {
+                errno = err;
+                return -1;
+            }
+        }
+        num_done += n;
+        if (!known_full || (size_t) num_done == max) {
+            break;
+        }
+    }
+
+    return num_done;
+}
+
+
+int
+loop_reading_splice (int fd, int out_fd, int tee_fd, size_t chunk, read_stats *rs)
+{
+    splice_ctx  sc;
+
+    int  in_pipe[2] = { -1, -1 };
+
+    unsigned long long  t_begin;
+
+    ssize_t  num_in;
+    ssize_t  num_out;
+    errno_t  err = 0;
+
+    memset(&sc, 0, sizeof sc);
+    sc.sc_out_fd = out_fd;
+    sc.sc_tee_fd = tee_fd;
+    sc.sc_tee_target = tee_fd;
+    sc.sc_tee_pipe[0] = sc.sc_tee_pipe[1] = -1;
+    sc.sc_rs = rs;
+
+    if (tee_fd >= 0 && !is_pipe_(tee_fd)) {
+        make_pipe_(sc.sc_tee_pipe, chunk);
+        if (sc.sc_tee_pipe[0] < 0) {
+            err = errno;
+            perror("pipe2(tee)");
+            return err;
+        }
+        sc.sc_tee_target = sc.sc_tee_pipe[1];
+    }
+    if (!is_pipe_(fd)) {
+        make_pipe_(in_pipe, chunk);
+        if (in_pipe[0] < 0) {
+            err = errno;
+            perror("pipe2(input)");
+            close_pipe_(sc.sc_tee_pipe);
+            return err;
+        }
+    }
+
+    t_begin = ulat_now_ns();
+
+    for (;;) {
+        if (in_pipe[0] < 0) {
+            num_in = forward_(&sc, fd, chunk, 0);
+        } else {
+            num_in = splice(fd, NULL, in_pipe[1], NULL, chunk, SPLICE_F_MOVE);
+            ++rs->rs_syscalls;
+            if (num_in > 0) {
+                num_out = forward_(&sc, in_pipe[0], (size_t) num_in, 1);
+                if (num_out < 0) {
+                    num_in = -1;
+                }
+            } else if (num_in < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                fprintf(stderr, "splice(%d) failed: errno %d = %s\n",
+                        fd, errno, strerror(errno));
+            }
+        }
+
+        if (num_in > 0) {
+            ++rs->rs_reads;
+            rs->rs_bytes += (unsigned long long) num_in;
+        } else if (0 == num_in) {
+            break;  /* EOF */
+        } else {
+            err = errno;  /* already reported */
+            break;
+        }
+    }
+
+    rs->rs_elapsed_ns = ulat_now_ns() - t_begin;
+
+    close_pipe_(in_pipe);
+    close_pipe_(sc.sc_tee_pipe);
+
+    return err;
+}
@@ -0,0 +1,468 @@
+/*
+ * demo-code/loop-reading-uring.c
+ *
+ * io_uring reading engine, with raw syscalls (no liburing):
+ * several reads in flight, registered buffers, linked timeouts.
+ *
+ * The data is still copied into user memory; what registered buffers save
+ * is the mapping (pinning) of the user pages on each read, and what
+ * the ring saves is a syscall per read: many completions are reaped,
+ * and as many reads submitted, with one io_uring_enter() call.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for syscall() */
+
+#include "loop-reading.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define URING_DEPTH_MAX  256
+
+/* user_data of the timeout SQEs; reads have the buffer index */
+#define TIMEOUT_USER_DATA  UINT64_MAX
+
+
+typedef struct {
+    int  ur_fd;
+
+    void   *ur_sq_ptr;
+    size_t  ur_sq_size;
+    void   *ur_cq_ptr;  /* same as 'ur_sq_ptr' with IORING_FEAT_SINGLE_MMAP */
+    size_t  ur_cq_size;
+
+    struct io_uring_sqe *ur_sqes;
+    size_t               ur_sqes_size;
+
+    _Atomic unsigned *ur_sq_tail;
+    unsigned         *ur_sq_array;
+    unsigned          ur_sq_mask;
+
+    _Atomic unsigned *ur_cq_head;
+    _Atomic unsigned *ur_cq_tail;
+    unsigned          ur_cq_mask;
+    struct io_uring_cqe *ur_cqes;
+
+    unsigned  ur_local_tail;  /* includes the SQEs not yet published */
+    unsigned  ur_to_submit;   /* SQEs not yet consumed by the kernel */
+} uring;
+
+
+static int
+uring_setup_ (unsigned entries, struct io_uring_params *params)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+uring_enter_ (int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags,
+                         NULL, 0);
+}
+
+static int
+uring_register_ (int ring_fd, unsigned opcode, const void *arg, unsigned nr_args)
+{
+    return (int) syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+
+static void
+uring_unmap_ (uring *ur)
+{
+    if (ur->ur_sqes != NULL) {
+        munmap(ur->ur_sqes, ur->ur_sqes_size);
+    }
+    if (ur->ur_cq_ptr != NULL && ur->ur_cq_ptr != ur->ur_sq_ptr) {
+        munmap(ur->ur_cq_ptr, ur->ur_cq_size);
+    }
+    if (ur->ur_sq_ptr != NULL) {
+        munmap(ur->ur_sq_ptr, ur->ur_sq_size);
+    }
+}
+
+/*
+ * Returns 0 or an errno value.
+ */
+static int
+uring_init_ (uring *ur, unsigned entries)
+{
+    struct io_uring_params  params;
+
+    errno_t  err;
+
+    unsigned  ix;
+
+    memset(ur, 0, sizeof *ur);
+    memset(&params, 0, sizeof params);
+
+    ur->ur_fd = uring_setup_(entries, &params);
+    if (ur->ur_fd < 0) {
+        err = errno;
+        fprintf(stderr, "io_uring_setup(%u) failed: errno %d = %s%s\n",
+                entries, err, strerror(err),
+                (EPERM == err || ENOSYS == err)
+                ? " (disabled? see /proc/sys/kernel/io_uring_disabled)" : "");
+        return err;
+    }
+
+    ur->ur_sq_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    ur->ur_cq_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ur->ur_cq_size > ur->ur_sq_size) {
+            ur->ur_sq_size = ur->ur_cq_size;
+        }
+        ur->ur_cq_size = ur->ur_sq_size;
+    }
+
+    ur->ur_sq_ptr = mmap(NULL, ur->ur_sq_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ur->ur_fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == ur->ur_sq_ptr) {
+        ur->ur_sq_ptr = NULL;
+        goto fail_mmap;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ur->ur_cq_ptr = ur->ur_sq_ptr;
+    } else {
+        ur->ur_cq_ptr = mmap(NULL, ur->ur_cq_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ur->ur_fd, IORING_OFF_CQ_RING);
+        if (MAP_FAILED == ur->ur_cq_ptr) {
+            ur->ur_cq_ptr = NULL;
+            goto fail_mmap;
+        }
+    }
+
+    ur->ur_sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+    ur->ur_sqes = mmap(NULL, ur->ur_sqes_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ur->ur_fd, IORING_OFF_SQES);
+    if (MAP_FAILED == ur->ur_sqes) {
+        ur->ur_sqes = NULL;
+        goto fail_mmap;
+    }
+
+    ur->ur_sq_tail = (_Atomic unsigned *) ((char *) ur->ur_sq_ptr + params.sq_off.tail);
+    ur->ur_sq_array = (unsigned *) ((char *) ur->ur_sq_ptr + params.sq_off.array);
+    ur->ur_sq_mask = *(unsigned *) ((char *) ur->ur_sq_ptr + params.sq_off.ring_mask);
+    ur->ur_local_tail = atomic_load_explicit(ur->ur_sq_tail, memory_order_relaxed);
+
+    ur->ur_cq_head = (_Atomic unsigned *) ((char *) ur->ur_cq_ptr + params.cq_off.head);
+    ur->ur_cq_tail = (_Atomic unsigned *) ((char *) ur->ur_cq_ptr + params.cq_off.tail);
+    ur->ur_cq_mask = *(unsigned *) ((char *) ur->ur_cq_ptr + params.cq_off.ring_mask);
+    ur->ur_cqes = (struct io_uring_cqe *) ((char *) ur->ur_cq_ptr + params.cq_off.cqes);
+
+    /* SQE slot N is always at position N of the index array. */
+    for (ix = 0; ix < params.sq_entries; ++ix) {
+        ur->ur_sq_array[ix] = ix;
+    }
+
+    return 0;
+
+fail_mmap:
+    err = errno;
+    perror("mmap(io_uring)");
+    uring_unmap_(ur);
+    close(ur->ur_fd);
+    return err;
+}
+
+static void
+uring_destroy_ (uring *ur)
+{
+    uring_unmap_(ur);
+    close(ur->ur_fd);
+}
+
+/*
+ * The ring has room for all the SQEs we ever queue (two per read),
+ * so there is no need to check for a full submission queue.
+ */
+static struct io_uring_sqe *
+uring_get_sqe_ (uring *ur)
+{
+    struct io_uring_sqe *const sqe = &ur->ur_sqes[ur->ur_local_tail & ur->ur_sq_mask];
+
+    memset(sqe, 0, sizeof *sqe);
+    ++ur->ur_local_tail;
+    ++ur->ur_to_submit;
+
+    return sqe;
+}
+
+/*
+ * Publishes the queued SQEs, submits them, and waits for at least
+ * 'min_complete' completions.  Returns 0 or an errno value.
+ */
+static int
+uring_submit_and_wait_ (uring *ur, unsigned min_complete, read_stats *rs)
+{
+    int  res;
+
+    atomic_store_explicit(ur->ur_sq_tail, ur->ur_local_tail, memory_order_release);
+
+    do {
+        res = uring_enter_(ur->ur_fd, ur->ur_to_submit, min_complete,
+                           (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0);
+        ++rs->rs_syscalls;
+        ++rs->rs_waits;
+    } while (res < 0 && EINTR == errno);
+
+    if (res < 0) {
+        res = errno;
+        perror("io_uring_enter()");
+        return res;
+    }
+
+    ur->ur_to_submit -= (unsigned) res;  /* normally all of them */
+
+    return 0;
+}
+
+
+static void
+queue_read_ (uring *ur, int fd, void *buf, size_t bufsize, unsigned buf_index,
+             unsigned long long offset, const struct __kernel_timespec *timeout)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe_(ur);
+
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) buf;
+    sqe->len = (uint32_t) bufsize;
+    sqe->off = offset;
+    sqe->buf_index = (uint16_t) buf_index;
+    sqe->user_data = buf_index;
+
+    if (timeout != NULL) {
+        sqe->flags = IOSQE_IO_LINK;
+
+        sqe = uring_get_sqe_(ur);
+        sqe->opcode = IORING_OP_LINK_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t) (uintptr_t) timeout;
+        sqe->len = 1;
+        sqe->user_data = TIMEOUT_USER_DATA;
+    }
+}
+
+
+int
+loop_reading_uring (int fd, size_t bufsize, unsigned depth, int timeout_ms,
+                    read_stats *rs)
+{
+    struct __kernel_timespec  timeout_ts;
+    struct stat               st;
+
+    unsigned long long  offsets[URING_DEPTH_MAX];  /* of the read in each buffer */
+    size_t              filled[URING_DEPTH_MAX];   /* by the short reads before */
+
+    struct iovec *iovs;
+    char         *bufs;
+
+    uring  ur;
+
+    unsigned long long  t_begin;
+    unsigned long long  next_offset;  /* regular files only */
+    unsigned long long  stop_offset = (unsigned long long) -1;  /* of the EOF, or of an error */
+
+    errno_t  err = 0;
+    errno_t  read_err = 0;  /* the first failed read; the others keep draining */
+
+    unsigned  head;
+    unsigned  tail;
+    unsigned  in_flight = 0;
+    unsigned  ix;
+
+    int  seekable;
+    int  at_eof = 0;
+
+    const struct __kernel_timespec *const timeout_p = (timeout_ms >= 0) ? &timeout_ts : NULL;
+
+    if (0 == depth || depth > URING_DEPTH_MAX) {
+        fprintf(stderr, "io_uring depth must be between 1 and %d.\n", URING_DEPTH_MAX);
+        return EINVAL;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        err = errno;
+        perror("fstat()");
+        return err;
+    }
+    seekable = S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+    next_offset = seekable ? (unsigned long long) lseek(fd, 0, SEEK_CUR) : 0;
+
+    timeout_ts.tv_sec = (timeout_ms >= 0) ? timeout_ms / 1000 : 0;
+    timeout_ts.tv_nsec = (timeout_ms >= 0) ? (long long) (timeout_ms % 1000) * 1000000 : 0;
+
+    bufs = aligned_alloc(4096, depth * ((bufsize + 4095) & ~(size_t) 4095));
+    iovs = calloc(depth, sizeof iovs[0]);
+    if (NULL == bufs || NULL == iovs) {
+        perror("aligned_alloc(uring buffers)");
+        free(iovs);
+        free(bufs);
+        return ENOMEM;
+    }
+
+    err = uring_init_(&ur, 2 * depth);
+    if (err != 0) {
+        free(iovs);
+        free(bufs);
+        return err;
+    }
+
+    for (ix = 0; ix < depth; ++ix) {
+        iovs[ix].iov_base = bufs + ix * ((bufsize + 4095) & ~(size_t) 4095);
+        iovs[ix].iov_len = bufsize;
+    }
+    if (uring_register_(ur.ur_fd, IORING_REGISTER_BUFFERS, iovs, depth) < 0) {
+        err = errno;
+        fprintf(stderr, "io_uring_register(BUFFERS) failed: errno %d = %s%s\n",
+                err, strerror(err),
+                (ENOMEM == err) ? " (RLIMIT_MEMLOCK too low?)" : "");
+        goto done;
+    }
+    ++rs->rs_syscalls;
+
+    t_begin = ulat_now_ns();
+
+    for (ix = 0; ix < depth; ++ix) {
+        filled[ix] = 0;
+        offsets[ix] = seekable ? next_offset : (unsigned long long) -1;
+        next_offset += bufsize;
+        queue_read_(&ur, fd, iovs[ix].iov_base, bufsize, ix, offsets[ix], timeout_p);
+        ++in_flight;
+    }
+
+    while (in_flight > 0) {
+        err = uring_submit_and_wait_(&ur, 1, rs);
+        if (err != 0) {
+            break;
+        }
+
+        head = atomic_load_explicit(ur.ur_cq_head, memory_order_relaxed);
+        tail = atomic_load_explicit(ur.ur_cq_tail, memory_order_acquire);
+
+        for (; head != tail; ++head) {
+            const struct io_uring_cqe *const cqe = &ur.ur_cqes[head & ur.ur_cq_mask];
+
+            const int  res = cqe->res;
+
+            if (TIMEOUT_USER_DATA == cqe->user_data) {
+                continue;  /* -ETIME if it fired, -ECANCELED if the read won */
+            }
+
+            ix = (unsigned) cqe->user_data;
+            --in_flight;
+
+            if (res > 0) {
+                ++rs->rs_reads;
+                rs->rs_bytes += (unsigned long long) res;
+
+                if ((size_t) res < bufsize - filled[ix]) {
+                    ++rs->rs_short_reads;
+                }
+                if (seekable && (size_t) res < bufsize - filled[ix]) {
+                    /* A short read of a regular file should only happen
+                     * at EOF: read the rest, which then returns 0.
+                     */
+                    filled[ix] += (size_t) res;
+                    offsets[ix] += (unsigned long long) res;
+                    queue_read_(&ur, fd, (char *) iovs[ix].iov_base + filled[ix],
+                                bufsize - filled[ix], ix, offsets[ix], timeout_p);
+                    ++in_flight;
+                    continue;
+                }
+                filled[ix] = 0;
+                offsets[ix] = seekable ? next_offset : (unsigned long long) -1;
+                next_offset += bufsize;
+            } else if (0 == res) {
+                at_eof = 1;
+                if (seekable && offsets[ix] < stop_offset) {
+                    stop_offset = offsets[ix];
+                }
+            } else if (-ECANCELED == res || -EINTR == res) {
+                /* Canceled by the linked timeout: no data, try again
+                 * (at the same offset, or there would be a hole).
+                 * Also after EOF, if the offset is before it.
+                 */
+                ++rs->rs_timeouts;
+                if (0 == ix) {
+                    fprintf(stderr, "io_uring read timed out after %d ms (%llu bytes so far).\n",
+                            timeout_ms, rs->rs_bytes);
+                }
+                if (!at_eof || (seekable && offsets[ix] < stop_offset)) {
+                    queue_read_(&ur, fd, (char *) iovs[ix].iov_base + filled[ix],
+                                bufsize - filled[ix], ix, offsets[ix], timeout_p);
+                    ++in_flight;
+                }
+                continue;
+            } else {
+                fprintf(stderr, "io_uring read failed: errno %d = %s\n",
+                        -res, strerror(-res));
+                if (0 == read_err) {
+                    read_err = -res;
+                }
+                at_eof = 1;
+                if (seekable && offsets[ix] < stop_offset) {
+                    stop_offset = offsets[ix];
+                }
+            }
+
+            /* No new offsets after EOF (or an error). */
+            if (!at_eof) {
+                queue_read_(&ur, fd, iovs[ix].iov_base, bufsize, ix, offsets[ix], timeout_p);
+                ++in_flight;
+            }
+        }
+
+        atomic_store_explicit(ur.ur_cq_head, head, memory_order_release);
+    }
+
+    rs->rs_elapsed_ns = ulat_now_ns() - t_begin;
+
+    if (0 == err) {
+        err = read_err;
+    }
+
+done:
+    uring_destroy_(&ur);
+    free(iovs);
+    free(bufs);
+
+    return err;
+}
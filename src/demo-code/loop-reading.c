@@ -0,0 +1,186 @@
+/*
+ * demo-code/loop-reading.c
+ *
+ * Reading loops (engines) that drain an input until EOF,
+ * counting bytes and syscalls, for comparing throughput.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "loop-reading.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+#include "util-ofd-flags.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+void
+show_read_stats (const read_stats *rs, const char *preamble, FILE *out_stream)
+{
+    const double  seconds = (double) rs->rs_elapsed_ns / 1e9;
+    const double  mib = (double) rs->rs_bytes / (1024.0 * 1024.0);
+
+    fprintf(out_stream, "%s Read %llu bytes in %.3f s: %.1f MB/s, %.0f reads/s.\n",
+            preamble, rs->rs_bytes, seconds,
+            (seconds > 0.0) ? (double) rs->rs_bytes / 1e6 / seconds : 0.0,
+            (seconds > 0.0) ? (double) rs->rs_reads / seconds : 0.0);
+
+    fprintf(out_stream, "%s %lu reads (%.0f bytes per read), %lu EAGAIN, %lu waits"
+            " (%lu timed out); %.1f syscalls per MiB.\n",
+            preamble, rs->rs_reads,
+            (rs->rs_reads > 0) ? (double) rs->rs_bytes / (double) rs->rs_reads : 0.0,
+            rs->rs_eagain, rs->rs_waits, rs->rs_timeouts,
+            (mib > 0.0) ? (double) rs->rs_syscalls / mib : 0.0);
+    if (rs->rs_short_reads > 0) {
+        fprintf(out_stream, "%s %lu short reads.\n", preamble, rs->rs_short_reads);
+    }
+}
+
+
+int
+loop_reading_blocking (int fd, char *buf, size_t bufsize, read_stats *rs)
+{
+    const unsigned long long  t_begin = ulat_now_ns();
+
+    ssize_t  num_read;
+    errno_t  read_err = 0;
+
+    for (;;) {
+        num_read = read(fd, buf, bufsize);
+        ++rs->rs_syscalls;
+        if (num_read > 0) {
+            ++rs->rs_reads;
+            rs->rs_bytes += (unsigned long long) num_read;
+        } else if (0 == num_read) {
+            break;  /* EOF */
+        } else if (EINTR == errno) {
+            continue;
+        } else {
+            read_err = errno;
+            fprintf(stderr, "read(%d) failed: errno %d = %s\n",
+                    fd, read_err, strerror(read_err));
+            break;
+        }
+    }
+
+    rs->rs_elapsed_ns = ulat_now_ns() - t_begin;
+
+    return read_err;
+}
+
+
+int
+loop_reading_epoll (int fd, char *buf, size_t bufsize, int timeout_ms,
+                    read_stats *rs)
+{
+    struct epoll_event  ev;
+
+    unsigned long long  t_begin;
+
+    ssize_t  num_read;
+    errno_t  err = 0;
+
+    int  epfd;
+    int  n_ready;
+    int  at_eof = 0;
+
+    if (set_ofd_status_flags(fd, O_NONBLOCK) < 0) {
+        return EBADF;  /* already reported */
+    }
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        err = errno;
+        perror("epoll_create1()");
+        return err;
+    }
+
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        err = errno;
+        fprintf(stderr, "epoll_ctl(ADD, %d) failed: errno %d = %s%s\n",
+                fd, err, strerror(err),
+                (EPERM == err) ? " (regular files and directories do not support epoll)" : "");
+        close(epfd);
+        return err;
+    }
+
+    t_begin = ulat_now_ns();
+
+    while (!at_eof) {
+        n_ready = epoll_wait(epfd, &ev, 1, timeout_ms);
+        ++rs->rs_waits;
+        ++rs->rs_syscalls;
+
+        if (n_ready < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            err = errno;
+            perror("epoll_wait()");
+            break;
+        }
+        if (0 == n_ready) {
+            ++rs->rs_timeouts;
+            fprintf(stderr, "epoll_wait() timed out after %d ms (%llu bytes so far).\n",
+                    timeout_ms, rs->rs_bytes);
+            continue;
+        }
+
+        /* Ready (or hung up): drain until EAGAIN or EOF. */
+        for (;;) {
+            num_read = read(fd, buf, bufsize);
+            ++rs->rs_syscalls;
+            if (num_read > 0) {
+                ++rs->rs_reads;
+                rs->rs_bytes += (unsigned long long) num_read;
+            } else if (0 == num_read) {
+                at_eof = 1;
+                break;
+            } else if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                ++rs->rs_eagain;
+                break;
+            } else if (EINTR == errno) {
+                continue;
+            } else {
+                err = errno;
+                fprintf(stderr, "read(%d) failed: errno %d = %s\n",
+                        fd, err, strerror(err));
+                at_eof = 1;
+                break;
+            }
+        }
+    }
+
+    rs->rs_elapsed_ns = ulat_now_ns() - t_begin;
+
+    close(epfd);
+
+    return err;
+}
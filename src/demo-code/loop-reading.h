@@ -0,0 +1,76 @@
+/*
+ * demo-code/loop-reading.h
+ *
+ * Reading loops (engines) that drain an input until EOF,
+ * counting bytes and syscalls, for comparing throughput.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+typedef struct {
+    unsigned long long  rs_bytes;
+
+    unsigned long  rs_reads;     /* calls (or completions) that returned data */
+    unsigned long  rs_eagain;    /* calls that found nothing to read */
+    unsigned long  rs_waits;     /* calls that only wait: epoll_wait(), ... */
+    unsigned long  rs_timeouts;  /* waits that timed out */
+    unsigned long  rs_short_reads;  /* io_uring: completions with less than asked for */
+
+    unsigned long  rs_syscalls;  /* with io_uring, reads and waits are not syscalls */
+
+    unsigned long long  rs_elapsed_ns;
+} read_stats;
+
+
+/*
+ * Throughput (MB/s), bytes per read and syscalls per MiB.
+ */
+void  show_read_stats(const read_stats *rs, const char *preamble, FILE *out_stream);
+
+/*
+ * Blocking read() until EOF: the baseline.
+ * Returns 0 at EOF, or the errno value of a failed read().
+ */
+int  loop_reading_blocking(int fd, char *buf, size_t bufsize, read_stats *rs);
+
+/*
+ * Sets O_NONBLOCK on 'fd', then waits with epoll_wait() and
+ * drains with read() until EAGAIN, until EOF.  A negative 'timeout_ms'
+ * means no timeout; each timeout is counted and reported.
+ * Regular files cannot be used with epoll (EPERM).
+ * Returns 0 at EOF, or an errno value.
+ */
+int  loop_reading_epoll(int fd, char *buf, size_t bufsize, int timeout_ms,
+                        read_stats *rs);
+
+/*
+ * io_uring, with raw syscalls (see loop-reading-uring.c):
+ * keeps 'depth' reads of 'bufsize' bytes in flight, into buffers
+ * registered with the ring (IORING_OP_READ_FIXED).  Each read is linked
+ * to a timeout (IORING_OP_LINK_TIMEOUT) if 'timeout_ms' is not negative;
+ * a timed out read is counted and submitted again.
+ * Regular files are read at explicit offsets, everything else
+ * at the current position.
+ * Returns 0 at EOF, or an errno value.
+ */
+int  loop_reading_uring(int fd, size_t bufsize, unsigned depth, int timeout_ms,
+                        read_stats *rs);
+
+/*
+ * splice() and tee() (see loop-reading-splice.c): moves the input
+ * to 'out_fd', at most 'chunk' bytes per call, and copies it to 'tee_fd'
+ * too if not negative, without reading it into user memory.
+ * Inputs and tee fds that are not pipes go through intermediate pipes.
+ * Returns 0 at EOF, or an errno value.
+ */
+int  loop_reading_splice(int fd, int out_fd, int tee_fd, size_t chunk,
+                         read_stats *rs);
@@ -0,0 +1,273 @@
+/*
+ * demo-code/mmap-hugepages.c
+ *
+ * Large anonymous mappings with and without huge pages:
+ * page faults, access throughput and how much THP actually gave us.
+ *
+ * With 4 KiB pages, a strided pass over a large region needs
+ * a TLB entry (and, on first touch, a page fault) for every page;
+ * a 2 MiB page covers 512 of them.  Transparent huge pages (THP) are
+ * best effort: the kernel may still fall back to small pages, which is why
+ * AnonHugePages is shown next to the timings.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for MAP_ANONYMOUS, MAP_HUGETLB, madvise() */
+
+#include "mmap-hugepages.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+/*
+ * The default huge page size on x86-64 (and most arm64 kernels);
+ * MAP_HUGETLB uses the default size, see Hugepagesize in /proc/meminfo.
+ */
+#define HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+/* read passes after the first (faulting) write pass */
+#define ACCESS_PASSES  4
+
+/*
+ * The read passes visit the slots in a scattered order,
+ * slot = (i * ACCESS_STEP) mod n_slots, so the prefetchers do not hide
+ * the TLB misses; a prime step is coprime with any practical slot count.
+ */
+#define ACCESS_STEP  1000003
+
+
+typedef enum {
+    HP_HUGETLB,
+    HP_MADV_HUGEPAGE,
+    HP_DEFAULT,
+    HP_MADV_NOHUGEPAGE,
+    HP_N_KINDS
+} hp_kind;
+
+static const char *const Kind_Names[HP_N_KINDS] = {
+    "MAP_HUGETLB",
+    "MADV_HUGEPAGE",
+    "(no advice)",
+    "MADV_NOHUGEPAGE"
+};
+
+
+/*
+ * Reserves 'len' plus a huge page, then unmaps the unaligned head
+ * and the tail, so THP can use huge pages from the first byte on.
+ * MAP_HUGETLB mappings are always aligned.
+ */
+static void *
+map_aligned_ (size_t len, int extra_flags)
+{
+    const size_t  reserved_len = len + HUGE_PAGE_SIZE;
+
+    char *reserved;
+    char *aligned;
+
+    if (extra_flags != 0) {
+        reserved = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+        return (MAP_FAILED == reserved) ? NULL : reserved;
+    }
+
+    reserved = mmap(NULL, reserved_len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == reserved) {
+        return NULL;
+    }
+
+    aligned = (char *) (((uintptr_t) reserved + HUGE_PAGE_SIZE - 1)
+                        & ~(uintptr_t) (HUGE_PAGE_SIZE - 1));
+    if (aligned > reserved) {
+        munmap(reserved, (size_t) (aligned - reserved));
+    }
+    munmap(aligned + len, (size_t) (reserved + reserved_len - (aligned + len)));
+
+    return aligned;
+}
+
+/*
+ * Sum of AnonHugePages (THP) and Private_Hugetlb (MAP_HUGETLB), in KiB,
+ * over the smaps entries that overlap [begin, begin + len);
+ * -1 if /proc/self/smaps cannot be read.
+ */
+static long
+anon_huge_kib_ (const void *begin, size_t len)
+{
+    const uintptr_t  range_begin = (uintptr_t) begin;
+    const uintptr_t  range_end = range_begin + len;
+
+    char  line[512];
+
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+
+    unsigned long  vma_begin;
+    unsigned long  vma_end;
+
+    long  kib;
+    long  total = 0;
+
+    int  in_range = 0;
+
+    if (NULL == smaps) {
+        perror("fopen(/proc/self/smaps)");
+        return -1;
+    }
+
+    while (fgets(line, sizeof line, smaps) != NULL) {
+        if (sscanf(line, "%lx-%lx ", &vma_begin, &vma_end) == 2) {
+            in_range = (vma_begin < range_end && vma_end > range_begin);
+        } else if (in_range && (sscanf(line, "AnonHugePages: %ld kB", &kib) == 1
+                                || sscanf(line, "Private_Hugetlb: %ld kB", &kib) == 1)) {
+            total += kib;
+        }
+    }
+
+    fclose(smaps);
+
+    return total;
+}
+
+static void
+get_faults_ (long *minflt, long *majflt)
+{
+    struct rusage  ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        perror("getrusage()");
+        *minflt = *majflt = 0;
+        return;
+    }
+
+    *minflt = ru.ru_minflt;
+    *majflt = ru.ru_majflt;
+}
+
+static void
+run_one_ (hp_kind kind, size_t len, size_t stride)
+{
+    unsigned long long  t_begin;
+    unsigned long long  touch_ns;
+    unsigned long long  access_ns;
+    unsigned long long  n_accesses = 0;
+
+    volatile unsigned char *p;
+
+    long  minflt_before, majflt_before;
+    long  minflt_after, majflt_after;
+    long  huge_kib;
+
+    const size_t  n_slots = (len + stride - 1) / stride;
+
+    size_t  slot;
+    size_t  pos;
+
+    errno_t  err;
+
+    int  advice = -1;
+    int  pass;
+
+    p = map_aligned_(len, (HP_HUGETLB == kind) ? MAP_HUGETLB : 0);
+    if (NULL == p) {
+        err = errno;
+        printf("%-16s mmap() failed: errno %d = %s%s\n", Kind_Names[kind],
+               err, strerror(err),
+               (HP_HUGETLB == kind && ENOMEM == err)
+               ? " (reserve huge pages with: sysctl vm.nr_hugepages=N)" : "");
+        return;
+    }
+
+    if (HP_MADV_HUGEPAGE == kind) {
+        advice = MADV_HUGEPAGE;
+    } else if (HP_MADV_NOHUGEPAGE == kind) {
+        advice = MADV_NOHUGEPAGE;
+    }
+    if (advice >= 0 && madvise((void *) p, len, advice) != 0) {
+        err = errno;
+        printf("%-16s madvise() failed: errno %d = %s%s\n", Kind_Names[kind],
+               err, strerror(err),
+               (EINVAL == err) ? " (kernel without THP?)" : "");
+        munmap((void *) p, len);
+        return;
+    }
+
+    /* First touch: every page is faulted in here. */
+    get_faults_(&minflt_before, &majflt_before);
+    t_begin = ulat_now_ns();
+    for (pos = 0; pos < len; pos += stride) {
+        p[pos] = 1;
+    }
+    touch_ns = ulat_now_ns() - t_begin;
+    get_faults_(&minflt_after, &majflt_after);
+
+    huge_kib = anon_huge_kib_((const void *) p, len);
+
+    /* The same slots again, scattered, with all the pages present:
+     * what is left is mostly the cost of TLB (and cache) misses. */
+    t_begin = ulat_now_ns();
+    for (pass = 0; pass < ACCESS_PASSES; ++pass) {
+        slot = (size_t) pass;
+        for (pos = 0; pos < n_slots; ++pos) {
+            slot = (slot + ACCESS_STEP) % n_slots;
+            (void) p[slot * stride];
+            ++n_accesses;
+        }
+    }
+    access_ns = ulat_now_ns() - t_begin;
+
+    printf("%-16s %9.1f %10ld %8ld %12ld %10.2f %10.1f\n", Kind_Names[kind],
+           (double) touch_ns / 1e6,
+           minflt_after - minflt_before, majflt_after - majflt_before,
+           huge_kib,
+           (double) access_ns / (double) n_accesses,
+           (double) n_accesses / ((double) access_ns / 1e3));
+
+    munmap((void *) p, len);
+}
+
+
+void
+run_hugepage_experiments (size_t len, size_t stride)
+{
+    int  kind;
+
+    /* MAP_HUGETLB needs whole huge pages; keep all the kinds comparable. */
+    len = (len + HUGE_PAGE_SIZE - 1) & ~(size_t) (HUGE_PAGE_SIZE - 1);
+
+    printf("\nMapping %zu MiB, touching every %zu bytes;"
+           " then %d scattered read passes.\n",
+           len / (1024 * 1024), stride, ACCESS_PASSES);
+    printf("%-16s %9s %10s %8s %12s %10s %10s\n", "mapping", "touch ms",
+           "minflt", "majflt", "huge kB", "ns/access", "Macc/s");
+
+    for (kind = 0; kind < HP_N_KINDS; ++kind) {
+        run_one_((hp_kind) kind, len, stride);
+    }
+}
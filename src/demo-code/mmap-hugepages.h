@@ -0,0 +1,28 @@
+/*
+ * demo-code/mmap-hugepages.h
+ *
+ * Large anonymous mappings with and without huge pages:
+ * page faults, access throughput and how much THP actually gave us.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <stddef.h>
+
+
+/*
+ * Maps 'len' bytes of anonymous memory in several ways:
+ * MAP_HUGETLB (needs pages reserved in vm.nr_hugepages), MADV_HUGEPAGE,
+ * no advice and MADV_NOHUGEPAGE.  Each region is first touched with
+ * one write per 'stride' bytes (counting minor and major faults, from
+ * getrusage()), then the same slots are read a few times, scattered
+ * (ns per access),
+ * and its huge page usage is taken from /proc/self/smaps.
+ * Shows one line per way of mapping, and a note for those that failed.
+ */
+void  run_hugepage_experiments(size_t len, size_t stride);
@@ -0,0 +1,412 @@
+/*
+ * demo-code/mmap-userfault.c
+ *
+ * Lazy population of a mapping with userfaultfd: missing pages are
+ * supplied by a handler thread (UFFDIO_COPY), as in a lazy snapshot restore.
+ *
+ * The faulting thread sleeps until the handler has read the fault event
+ * from the userfaultfd, produced the data and copied it in: two context
+ * switches and an ioctl() on top of what the kernel does for a zero-fill.
+ * Copying several pages per fault ('batch_pages') pays that once for
+ * the whole batch, as long as the accesses are sequential.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for syscall() and MAP_ANONYMOUS */
+
+#include "mmap-userfault.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+/* the generated pattern: each 64-bit word is its offset, XORed with this */
+#define PATTERN_KEY  0x5a5aa5a5c3c33c3cULL
+
+
+typedef struct {
+    char   *uh_base;
+    size_t  uh_len;
+    size_t  uh_page_size;
+
+    int       uh_uffd;
+    int       uh_stop_fd;     /* read end of a pipe: readable = stop */
+    int       uh_backing_fd;
+    unsigned  uh_batch_pages;
+
+    char *uh_buf;  /* 'uh_batch_pages' pages */
+
+    unsigned long       uh_n_faults;
+    unsigned long long  uh_n_pages;
+    unsigned long long  uh_n_present;  /* faulting pages found already copied */
+    unsigned long       uh_n_exists;   /* batches that overlapped present pages */
+    errno_t             uh_err;
+
+    ulat_hist  uh_service;  /* from the fault event to the end of the copy */
+} uffd_handler;
+
+
+static void
+fill_pattern_ (uint64_t *words, size_t offset, size_t len)
+{
+    size_t  ix;
+
+    for (ix = 0; ix < len / sizeof *words; ++ix) {
+        words[ix] = (offset + ix * sizeof *words) ^ PATTERN_KEY;
+    }
+}
+
+static errno_t
+fill_buf_ (uffd_handler *uh, size_t offset, size_t len)
+{
+    ssize_t  num_read;
+    size_t   done = 0;
+
+    if (uh->uh_backing_fd < 0) {
+        fill_pattern_((uint64_t *) uh->uh_buf, offset, len);
+        return 0;
+    }
+
+    /* Short reads: keep going until EOF; past it, zeroes. */
+    while (done < len) {
+        num_read = pread(uh->uh_backing_fd, uh->uh_buf + done, len - done,
+                         (off_t) (offset + done));
+        if (num_read < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return errno;
+        }
+        if (0 == num_read) {
+            break;
+        }
+        done += (size_t) num_read;
+    }
+    memset(uh->uh_buf + done, 0, len - done);
+
+    return 0;
+}
+
+/*
+ * UFFDIO_COPY of 'n_pages' from 'offset'; if some of them are already
+ * present (EEXIST, or EAGAIN after copying the pages before them),
+ * only the page that faulted is copied.
+ */
+static errno_t
+copy_pages_ (uffd_handler *uh, size_t offset, size_t n_pages, size_t fault_offset)
+{
+    struct uffdio_copy  copy;
+
+    errno_t  err;
+
+    err = fill_buf_(uh, offset, n_pages * uh->uh_page_size);
+    if (err != 0) {
+        return err;
+    }
+
+    memset(&copy, 0, sizeof copy);
+    copy.dst = (uintptr_t) (uh->uh_base + offset);
+    copy.src = (uintptr_t) uh->uh_buf;
+    copy.len = n_pages * uh->uh_page_size;
+    copy.mode = 0;
+
+    if (ioctl(uh->uh_uffd, UFFDIO_COPY, &copy) == 0) {
+        uh->uh_n_pages += n_pages;
+        return 0;
+    }
+    err = errno;
+    if (copy.copy > 0) {
+        uh->uh_n_pages += (unsigned long long) copy.copy / uh->uh_page_size;
+    }
+
+    if ((EEXIST == err || EAGAIN == err) && n_pages > 1) {
+        ++uh->uh_n_exists;
+        return copy_pages_(uh, fault_offset, 1, fault_offset);
+    }
+    if (EEXIST == err) {
+        ++uh->uh_n_present;  /* copied by an earlier batch */
+        return 0;
+    }
+
+    return err;
+}
+
+static void *
+handler_thread_ (void *arg)
+{
+    uffd_handler *const  uh = arg;
+
+    struct pollfd  pfds[2];
+    struct uffd_msg  msg;
+
+    unsigned long long  t_event;
+
+    ssize_t  num_read;
+
+    size_t  fault_offset;
+    size_t  offset;
+    size_t  n_pages;
+
+    pfds[0].fd = uh->uh_uffd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = uh->uh_stop_fd;
+    pfds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(pfds, 2, -1) < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            uh->uh_err = errno;
+            break;
+        }
+        if (pfds[1].revents != 0) {
+            break;
+        }
+
+        num_read = read(uh->uh_uffd, &msg, sizeof msg);
+        if (num_read < 0) {
+            if (EAGAIN == errno || EINTR == errno) {
+                continue;
+            }
+            uh->uh_err = errno;
+            break;
+        }
+        t_event = ulat_now_ns();
+
+        if (msg.event != UFFD_EVENT_PAGEFAULT) {
+            continue;
+        }
+        ++uh->uh_n_faults;
+
+        fault_offset = ((uintptr_t) msg.arg.pagefault.address - (uintptr_t) uh->uh_base)
+                       & ~(uh->uh_page_size - 1);
+
+        /* The batch starts at the faulting page, and stops at the end. */
+        offset = fault_offset;
+        n_pages = (uh->uh_len - offset) / uh->uh_page_size;
+        if (n_pages > uh->uh_batch_pages) {
+            n_pages = uh->uh_batch_pages;
+        }
+
+        uh->uh_err = copy_pages_(uh, offset, n_pages, fault_offset);
+        if (uh->uh_err != 0) {
+            struct uffdio_range  range;
+
+            fprintf(stderr, "UFFDIO_COPY at offset %zu failed: errno %d = %s\n",
+                    offset, uh->uh_err, strerror(uh->uh_err));
+
+            /* Wakes up the faulting thread; the kernel fills the rest. */
+            range.start = (uintptr_t) uh->uh_base;
+            range.len = uh->uh_len;
+            ioctl(uh->uh_uffd, UFFDIO_UNREGISTER, &range);
+            break;
+        }
+        ulat_hist_add(&uh->uh_service, ulat_now_ns() - t_event);
+    }
+
+    return NULL;
+}
+
+/*
+ * One write per page, each one timed.
+ */
+static unsigned long long
+touch_pages_ (char *base, size_t len, size_t page_size, ulat_hist *lh)
+{
+    const unsigned long long  t_begin = ulat_now_ns();
+
+    unsigned long long  t_page;
+
+    size_t  pos;
+
+    for (pos = 0; pos < len; pos += page_size) {
+        t_page = ulat_now_ns();
+        ((volatile char *) base)[pos + 8] = 1;
+        ulat_hist_add(lh, ulat_now_ns() - t_page);
+    }
+
+    return ulat_now_ns() - t_begin;
+}
+
+static void
+show_touch_ (const char *what, unsigned long long ns, size_t len, size_t page_size,
+             const ulat_hist *lh)
+{
+    char  preamble[64];
+
+    printf("%s: %.1f ms, %.0f ns per page, %.1f MB/s.\n", what,
+           (double) ns / 1e6, (double) ns / (double) (len / page_size),
+           (double) len * 1e3 / (double) ns);
+    snprintf(preamble, sizeof preamble, "  [%s, first touch]", what);
+    ulat_show_hist(lh, preamble, stdout);
+}
+
+static int
+open_uffd_ (void)
+{
+    int  uffd;
+
+#ifdef UFFD_USER_MODE_ONLY
+    /* Enough for faults in user space, and allowed to unprivileged users
+     * even with vm.unprivileged_userfaultfd = 0 (since Linux 5.11). */
+    uffd = (int) syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+    if (uffd >= 0 || errno != EINVAL) {
+        return uffd;
+    }
+#endif
+
+    uffd = (int) syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+
+    return uffd;
+}
+
+
+int
+run_userfault_bench (void *base, size_t len, int backing_fd, unsigned batch_pages)
+{
+    struct uffdio_api       api;
+    struct uffdio_register  reg;
+    struct uffdio_range     range;
+
+    uffd_handler  uh;
+    ulat_hist     touches;
+
+    pthread_t  handler_tid;
+
+    unsigned long long  ns;
+
+    int  stop_pipe[2];
+    int  mismatches = 0;
+
+    size_t  pos;
+
+    errno_t  err;
+
+    memset(&uh, 0, sizeof uh);
+    uh.uh_base = base;
+    uh.uh_len = len;
+    uh.uh_page_size = (size_t) sysconf(_SC_PAGESIZE);
+    uh.uh_backing_fd = backing_fd;
+    uh.uh_batch_pages = (batch_pages > 0) ? batch_pages : 1;
+    ulat_hist_reset(&uh.uh_service);
+
+    printf("\n%zu pages of %zu bytes, filled %s, %u page(s) per fault.\n",
+           len / uh.uh_page_size, uh.uh_page_size,
+           (backing_fd < 0) ? "with a generated pattern" : "from the backing file",
+           uh.uh_batch_pages);
+
+    /* The baseline: zero-filled by the kernel. */
+    ulat_hist_reset(&touches);
+    ns = touch_pages_(base, len, uh.uh_page_size, &touches);
+    show_touch_("kernel zero-fill", ns, len, uh.uh_page_size, &touches);
+
+    /*
+     * Same range, but anonymous: a private mapping of /dev/zero can be
+     * registered, yet UFFDIO_COPY into it fails with EFAULT (seen with
+     * Linux 6.18).  Replacing it also discards the zero-filled pages.
+     */
+    if (mmap(base, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != base) {
+        perror("mmap(MAP_ANONYMOUS | MAP_FIXED)");
+        return 41;
+    }
+
+    uh.uh_uffd = open_uffd_();
+    if (uh.uh_uffd < 0) {
+        err = errno;
+        fprintf(stderr, "userfaultfd() failed: errno %d = %s%s\n", err, strerror(err),
+                (EPERM == err) ? " (see /proc/sys/vm/unprivileged_userfaultfd)" : "");
+        return 42;
+    }
+
+    memset(&api, 0, sizeof api);
+    api.api = UFFD_API;
+    memset(&reg, 0, sizeof reg);
+    reg.range.start = (uintptr_t) base;
+    reg.range.len = len;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if (ioctl(uh.uh_uffd, UFFDIO_API, &api) != 0
+        || ioctl(uh.uh_uffd, UFFDIO_REGISTER, &reg) != 0) {
+        perror("ioctl(UFFDIO_API / UFFDIO_REGISTER)");
+        return 43;
+    }
+
+    uh.uh_buf = malloc((size_t) uh.uh_batch_pages * uh.uh_page_size);
+    if (NULL == uh.uh_buf || pipe(stop_pipe) != 0) {
+        perror("malloc / pipe");
+        return 44;
+    }
+    uh.uh_stop_fd = stop_pipe[0];
+
+    err = pthread_create(&handler_tid, NULL, handler_thread_, &uh);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create() failed: errno %d = %s\n",
+                err, strerror(err));
+        return 45;
+    }
+
+    ulat_hist_reset(&touches);
+    ns = touch_pages_(base, len, uh.uh_page_size, &touches);
+
+    close(stop_pipe[1]);  /* POLLHUP for the handler */
+    pthread_join(handler_tid, NULL);
+    close(stop_pipe[0]);
+
+    show_touch_("userfaultfd", ns, len, uh.uh_page_size, &touches);
+    printf("Handler: %lu faults, %llu pages copied, %llu found present,"
+           " %lu batches fell back to one page.\n",
+           uh.uh_n_faults, uh.uh_n_pages, uh.uh_n_present, uh.uh_n_exists);
+    ulat_show_hist(&uh.uh_service, "  [handler, event to copy done]", stdout);
+
+    if (backing_fd < 0) {
+        /* The pattern must be there, except for the bytes we wrote. */
+        for (pos = 0; pos < len; pos += uh.uh_page_size) {
+            if (((const uint64_t *) base)[(pos + 64) / sizeof (uint64_t)]
+                != ((pos + 64) ^ PATTERN_KEY)) {
+                ++mismatches;
+            }
+        }
+        printf("Pattern check: %d page(s) with unexpected content.\n", mismatches);
+    }
+
+    range.start = (uintptr_t) base;
+    range.len = len;
+    ioctl(uh.uh_uffd, UFFDIO_UNREGISTER, &range);
+    close(uh.uh_uffd);
+    free(uh.uh_buf);
+
+    return (uh.uh_err != 0 || mismatches != 0) ? 46 : 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * demo-code/mmap-userfault.h
+ *
+ * Lazy population of a mapping with userfaultfd: missing pages are
+ * supplied by a handler thread (UFFDIO_COPY), as in a lazy snapshot restore.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <stddef.h>
+
+
+/*
+ * 'base' and 'len' must be page aligned, in a private (anonymous or
+ * /dev/zero) mapping that is readable and writable.
+ *
+ * First touches every page with the kernel filling them with zeroes,
+ * then maps the range again, anonymous, registers it with
+ * userfaultfd and touches every page again: now each missing page is
+ * filled by a handler thread, 'batch_pages' pages per fault, with
+ * a generated pattern or, if 'backing_fd' is not negative, from that file
+ * (at the same offset; zeroes past its end).  Shows the latency of
+ * each first touch in both cases, and the handler's service time.
+ *
+ * Returns 0, or a non-zero exit code (already reported).
+ */
+int  run_userfault_bench(void *base, size_t len, int backing_fd, unsigned batch_pages);
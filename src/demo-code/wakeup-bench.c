@@ -0,0 +1,695 @@
+/*
+ * demo-code/wakeup-bench.c
+ *
+ * Benchmarks for waking up threads, with semaphores,
+ * condition variables and raw futexes.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for syscall() */
+
+#include "wakeup-bench.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define WB_CACHE_LINE  64
+
+/* Rounds not measured, before the measured ones: threads get started,
+ * stacks and pages get touched.
+ */
+#define WB_WARMUP_ROUNDS_MAX  100
+
+
+typedef enum {
+    WB_SEM,
+    WB_COND_LOCKED,    /* signal/broadcast with the mutex held */
+    WB_COND_UNLOCKED,  /* signal/broadcast after releasing the mutex */
+    WB_FUTEX,
+    WB_CHAIN,    /* one-to-many only: each woken waiter wakes the next one */
+    WB_SHARDED,  /* one-to-many only: a condvar for each group of waiters */
+
+    WB_N_KINDS
+} wb_kind;
+
+#define WB_N_PINGPONG_KINDS  (WB_FUTEX + 1)
+
+#define WB_SHARD_SIZE  8  /* waiters per condvar, for WB_SHARDED */
+
+static const char *const  Pingpong_Names[WB_N_PINGPONG_KINDS] = {
+    "sem_post/sem_wait",
+    "cond_signal, locked",
+    "cond_signal, unlocked",
+    "futex wake 1"
+};
+
+static const char *const  Fanout_Names[WB_N_KINDS] = {
+    "sem_post per waiter",
+    "cond_broadcast, locked",
+    "cond_broadcast, unlocked",
+    "futex wake all",
+    "cond_signal chain",
+    "cond_broadcast, sharded"
+};
+
+
+static long
+futex_ (atomic_uint *uaddr, int op, unsigned int val)
+{
+    return syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+}
+
+static void
+sem_wait_no_eintr_ (sem_t *sem)
+{
+    while (sem_wait(sem) != 0) {
+        if (errno != EINTR) {
+            perror("sem_wait()");
+            exit(51);
+        }
+    }
+}
+
+static void
+create_thread_ (pthread_t *tid, void * (*start_routine)(void *), void *arg)
+{
+    const errno_t  res = pthread_create(tid, NULL, start_routine, arg);
+
+    if (res != 0) {
+        fprintf(stderr, "pthread_create() failed, returning the errno value %d = %s\n",
+                res, strerror(res));
+        exit(52);
+    }
+}
+
+static unsigned long
+warmup_rounds_ (unsigned long rounds)
+{
+    return (rounds / 10 < WB_WARMUP_ROUNDS_MAX) ? rounds / 10 : WB_WARMUP_ROUNDS_MAX;
+}
+
+
+/*
+ * Ping-pong.
+ *
+ * A channel carries a token in one direction; post() leaves the token,
+ * wait() blocks until there is one, then takes it.
+ */
+
+typedef struct {
+    sem_t  ch_sem;
+
+    pthread_mutex_t  ch_mutex;
+    pthread_cond_t   ch_cond;
+    int              ch_flag;  /* protected by 'ch_mutex' */
+
+    alignas(WB_CACHE_LINE) atomic_uint  ch_word;  /* for the futex */
+} wb_channel;
+
+typedef struct {
+    wb_kind  pp_kind;
+
+    wb_channel  pp_ping;  /* to the echo thread */
+    wb_channel  pp_pong;  /* back to the main thread */
+
+    /* Written before posting to 'pp_ping', read after waiting: */
+    unsigned long long  pp_stamp;
+    int                 pp_stop;
+    int                 pp_record;
+
+    ulat_hist  pp_hist;  /* one-way latency, measured by the echo thread */
+} wb_pingpong;
+
+
+static void
+init_channel_ (wb_channel *ch, const pthread_mutexattr_t *mutexattr)
+{
+    sem_init(&ch->ch_sem, 0, 0);
+    pthread_mutex_init(&ch->ch_mutex, mutexattr);
+    pthread_cond_init(&ch->ch_cond, NULL);
+    ch->ch_flag = 0;
+    atomic_init(&ch->ch_word, 0);
+}
+
+static void
+destroy_channel_ (wb_channel *ch)
+{
+    pthread_cond_destroy(&ch->ch_cond);
+    pthread_mutex_destroy(&ch->ch_mutex);
+    sem_destroy(&ch->ch_sem);
+}
+
+static void
+channel_post_ (wb_channel *ch, wb_kind kind)
+{
+    switch (kind) {
+    case WB_SEM:
+        sem_post(&ch->ch_sem);
+        break;
+    case WB_COND_LOCKED:
+        pthread_mutex_lock(&ch->ch_mutex);
+        ch->ch_flag = 1;
+        pthread_cond_signal(&ch->ch_cond);
+        pthread_mutex_unlock(&ch->ch_mutex);
+        break;
+    case WB_COND_UNLOCKED:
+        pthread_mutex_lock(&ch->ch_mutex);
+        ch->ch_flag = 1;
+        pthread_mutex_unlock(&ch->ch_mutex);
+        pthread_cond_signal(&ch->ch_cond);
+        break;
+    case WB_FUTEX:
+        /* Always a syscall: no waiter bookkeeping, raw futex cost. */
+        atomic_store_explicit(&ch->ch_word, 1, memory_order_release);
+        futex_(&ch->ch_word, FUTEX_WAKE_PRIVATE, 1);
+        break;
+    default:
+        break;
+    }
+}
+
+static void
+channel_wait_ (wb_channel *ch, wb_kind kind)
+{
+    switch (kind) {
+    case WB_SEM:
+        sem_wait_no_eintr_(&ch->ch_sem);
+        break;
+    case WB_COND_LOCKED:
+    case WB_COND_UNLOCKED:
+        pthread_mutex_lock(&ch->ch_mutex);
+        while (!ch->ch_flag) {
+            pthread_cond_wait(&ch->ch_cond, &ch->ch_mutex);
+        }
+        ch->ch_flag = 0;
+        pthread_mutex_unlock(&ch->ch_mutex);
+        break;
+    case WB_FUTEX:
+        while (0 == atomic_exchange_explicit(&ch->ch_word, 0, memory_order_acquire)) {
+            futex_(&ch->ch_word, FUTEX_WAIT_PRIVATE, 0);  /* EAGAIN, EINTR: check again */
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void *
+echo_thread_func_ (void *arg)
+{
+    wb_pingpong *const pp = arg;
+
+    for (;;) {
+        channel_wait_(&pp->pp_ping, pp->pp_kind);
+        if (pp->pp_record) {
+            ulat_hist_add(&pp->pp_hist, ulat_now_ns() - pp->pp_stamp);
+        }
+        if (pp->pp_stop) {
+            break;
+        }
+        channel_post_(&pp->pp_pong, pp->pp_kind);
+    }
+
+    return pp;
+}
+
+/*
+ * Returns the rate of handoffs (two per round trip), per second.
+ */
+static double
+run_pingpong_ (wb_pingpong *pp, unsigned long round_trips)
+{
+    const unsigned long  warmup = warmup_rounds_(round_trips);
+
+    pthread_t  tid;
+
+    unsigned long long  t_begin = 0;
+    unsigned long long  elapsed_ns;
+
+    unsigned long  ix;
+
+    create_thread_(&tid, &echo_thread_func_, pp);
+
+    for (ix = 0; ix < warmup + round_trips; ++ix) {
+        if (ix == warmup) {
+            pp->pp_record = 1;
+            t_begin = ulat_now_ns();
+        }
+        pp->pp_stamp = ulat_now_ns();
+        channel_post_(&pp->pp_ping, pp->pp_kind);
+        channel_wait_(&pp->pp_pong, pp->pp_kind);
+    }
+    elapsed_ns = ulat_now_ns() - t_begin;
+
+    pp->pp_record = 0;
+    pp->pp_stop = 1;
+    channel_post_(&pp->pp_ping, pp->pp_kind);
+    pthread_join(tid, NULL);
+
+    return 2.0 * (double) round_trips * 1e9 / (double) elapsed_ns;
+}
+
+void
+run_pingpong_benchmarks (unsigned long round_trips,
+                         const pthread_mutexattr_t *mutexattr)
+{
+    wb_pingpong *pp;
+
+    double              rates[WB_N_PINGPONG_KINDS];
+    unsigned long long  p50[WB_N_PINGPONG_KINDS];
+    unsigned long long  p99[WB_N_PINGPONG_KINDS];
+
+    int  kind;
+
+    pp = aligned_alloc(WB_CACHE_LINE, sizeof *pp);
+    if (NULL == pp) {
+        perror("aligned_alloc(pingpong)");
+        exit(53);
+    }
+
+    printf("\n=== Ping-pong: %lu round trips between two threads\n", round_trips);
+
+    for (kind = 0; kind < WB_N_PINGPONG_KINDS; ++kind) {
+        memset(pp, 0, sizeof *pp);
+        pp->pp_kind = (wb_kind) kind;
+        init_channel_(&pp->pp_ping, mutexattr);
+        init_channel_(&pp->pp_pong, mutexattr);
+        ulat_hist_reset(&pp->pp_hist);
+
+        rates[kind] = run_pingpong_(pp, round_trips);
+
+        printf("%s: %.0f handoffs/s\n", Pingpong_Names[kind], rates[kind]);
+        ulat_show_hist(&pp->pp_hist, "  one-way wakeup:", stdout);
+
+        p50[kind] = ulat_hist_percentile(&pp->pp_hist, 50.0);
+        p99[kind] = ulat_hist_percentile(&pp->pp_hist, 99.0);
+
+        destroy_channel_(&pp->pp_ping);
+        destroy_channel_(&pp->pp_pong);
+    }
+
+    printf("\n%-26s %12s %12s %12s\n", "primitive", "handoffs/s", "p50 usec", "p99 usec");
+    for (kind = 0; kind < WB_N_PINGPONG_KINDS; ++kind) {
+        printf("%-26s %12.0f %12.3f %12.3f\n", Pingpong_Names[kind],
+               rates[kind], p50[kind] / 1e3, p99[kind] / 1e3);
+    }
+
+    free(pp);
+}
+
+
+/*
+ * One-to-many.
+ *
+ * Each round has a generation number; a waiter is done with a round
+ * when it has seen the new generation.  The last waiter to acknowledge
+ * posts 'fo_ack_sem' --- the same (semaphore) way for all kinds,
+ * so the acknowledgement cost does not differ between kinds.
+ *
+ * A single condvar broadcast makes a thundering herd: all the waiters
+ * become runnable at once, then each of them has to get the mutex.
+ * The alternatives: a chain, where only one waiter is woken and
+ * it wakes the next one; or shards, a condvar (and mutex) for each group
+ * of WB_SHARD_SIZE waiters, so the herd on each mutex is smaller.
+ */
+
+typedef struct {
+    alignas(WB_CACHE_LINE) pthread_mutex_t  sl_mutex;
+    pthread_cond_t   sl_cond;
+    unsigned int     sl_gen;  /* protected by 'sl_mutex' */
+} wb_slot;
+
+typedef struct {
+    wb_kind  fo_kind;
+    int      fo_n_waiters;
+
+    sem_t   *fo_sems;   /* one per waiter (WB_SEM) */
+    wb_slot *fo_slots;  /* one per waiter (WB_CHAIN), per shard (WB_SHARDED) */
+    int      fo_n_shards;
+
+    pthread_mutex_t  fo_mutex;
+    pthread_cond_t   fo_cond;
+    unsigned int     fo_gen;  /* protected by 'fo_mutex' */
+
+    alignas(WB_CACHE_LINE) atomic_uint  fo_futex_gen;
+    alignas(WB_CACHE_LINE) atomic_int   fo_n_acked;
+
+    sem_t  fo_ack_sem;
+
+    /* Written before the wakeup: */
+    unsigned long long  fo_stamp;
+    int                 fo_stop;
+
+    unsigned long long *fo_woken_ns;  /* one per waiter */
+} wb_fanout;
+
+typedef struct {
+    wb_fanout *fw_fanout;
+    int        fw_index;
+} wb_fanout_waiter;
+
+
+static void
+slot_wait_ (wb_slot *sl, unsigned int *seen_gen)
+{
+    pthread_mutex_lock(&sl->sl_mutex);
+    while (sl->sl_gen == *seen_gen) {
+        pthread_cond_wait(&sl->sl_cond, &sl->sl_mutex);
+    }
+    *seen_gen = sl->sl_gen;
+    pthread_mutex_unlock(&sl->sl_mutex);
+}
+
+static void
+slot_wake_ (wb_slot *sl, int all)
+{
+    pthread_mutex_lock(&sl->sl_mutex);
+    ++sl->sl_gen;
+    if (all) {
+        pthread_cond_broadcast(&sl->sl_cond);
+    } else {
+        pthread_cond_signal(&sl->sl_cond);
+    }
+    pthread_mutex_unlock(&sl->sl_mutex);
+}
+
+static void
+fanout_wait_ (wb_fanout *fo, int ix, unsigned int *seen_gen)
+{
+    unsigned int  gen;
+
+    switch (fo->fo_kind) {
+    case WB_SEM:
+        sem_wait_no_eintr_(&fo->fo_sems[ix]);
+        break;
+    case WB_COND_LOCKED:
+    case WB_COND_UNLOCKED:
+        pthread_mutex_lock(&fo->fo_mutex);
+        while (fo->fo_gen == *seen_gen) {
+            pthread_cond_wait(&fo->fo_cond, &fo->fo_mutex);
+        }
+        *seen_gen = fo->fo_gen;
+        pthread_mutex_unlock(&fo->fo_mutex);
+        break;
+    case WB_FUTEX:
+        while ((gen = atomic_load_explicit(&fo->fo_futex_gen, memory_order_acquire))
+               == *seen_gen) {
+            futex_(&fo->fo_futex_gen, FUTEX_WAIT_PRIVATE, *seen_gen);
+        }
+        *seen_gen = gen;
+        break;
+    case WB_CHAIN:
+        slot_wait_(&fo->fo_slots[ix], seen_gen);
+        /* Pass it on, even when stopping: */
+        if (ix + 1 < fo->fo_n_waiters) {
+            slot_wake_(&fo->fo_slots[ix + 1], 0);
+        }
+        break;
+    case WB_SHARDED:
+        slot_wait_(&fo->fo_slots[ix / WB_SHARD_SIZE], seen_gen);
+        break;
+    default:
+        break;
+    }
+}
+
+static void
+fanout_wake_all_ (wb_fanout *fo)
+{
+    int  ix;
+
+    switch (fo->fo_kind) {
+    case WB_SEM:
+        for (ix = 0; ix < fo->fo_n_waiters; ++ix) {
+            sem_post(&fo->fo_sems[ix]);
+        }
+        break;
+    case WB_COND_LOCKED:
+        pthread_mutex_lock(&fo->fo_mutex);
+        ++fo->fo_gen;
+        pthread_cond_broadcast(&fo->fo_cond);
+        pthread_mutex_unlock(&fo->fo_mutex);
+        break;
+    case WB_COND_UNLOCKED:
+        pthread_mutex_lock(&fo->fo_mutex);
+        ++fo->fo_gen;
+        pthread_mutex_unlock(&fo->fo_mutex);
+        pthread_cond_broadcast(&fo->fo_cond);
+        break;
+    case WB_FUTEX:
+        atomic_fetch_add_explicit(&fo->fo_futex_gen, 1, memory_order_release);
+        futex_(&fo->fo_futex_gen, FUTEX_WAKE_PRIVATE, INT_MAX);
+        break;
+    case WB_CHAIN:
+        slot_wake_(&fo->fo_slots[0], 0);
+        break;
+    case WB_SHARDED:
+        for (ix = 0; ix < fo->fo_n_shards; ++ix) {
+            slot_wake_(&fo->fo_slots[ix], 1);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Voluntary plus involuntary context switches, of all the threads.
+ */
+static long
+context_switches_ (void)
+{
+    struct rusage  ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        perror("getrusage()");
+        exit(57);
+    }
+
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+static void *
+fanout_waiter_func_ (void *arg)
+{
+    wb_fanout_waiter *const fw = arg;
+    wb_fanout *const        fo = fw->fw_fanout;
+
+    unsigned int  seen_gen = 0;
+
+    for (;;) {
+        fanout_wait_(fo, fw->fw_index, &seen_gen);
+        fo->fo_woken_ns[fw->fw_index] = ulat_now_ns();
+
+        if (fo->fo_stop) {
+            break;
+        }
+        if (fo->fo_n_waiters ==
+            1 + atomic_fetch_add_explicit(&fo->fo_n_acked, 1, memory_order_acq_rel)) {
+            sem_post(&fo->fo_ack_sem);
+        }
+    }
+
+    return fw;
+}
+
+/*
+ * Returns the rate of rounds, per second;
+ * stores the context switches per round in '*csw_per_round'.
+ */
+static double
+run_fanout_ (wb_fanout *fo, unsigned long rounds,
+             ulat_hist *first_hist, ulat_hist *all_hist, double *csw_per_round)
+{
+    const unsigned long  warmup = warmup_rounds_(rounds);
+    const int            n = fo->fo_n_waiters;
+
+    pthread_t        *tids;
+    wb_fanout_waiter *waiters;
+
+    unsigned long long  t_begin = 0;
+    unsigned long long  elapsed_ns;
+    unsigned long long  first;
+    unsigned long long  last;
+
+    long  csw_begin = 0;
+
+    unsigned long  round;
+    int            ix;
+
+    tids = calloc((size_t) n, sizeof tids[0]);
+    waiters = calloc((size_t) n, sizeof waiters[0]);
+    if (NULL == tids || NULL == waiters) {
+        perror("calloc(tids, waiters)");
+        exit(54);
+    }
+
+    for (ix = 0; ix < n; ++ix) {
+        waiters[ix].fw_fanout = fo;
+        waiters[ix].fw_index = ix;
+        create_thread_(&tids[ix], &fanout_waiter_func_, &waiters[ix]);
+    }
+
+    for (round = 0; round < warmup + rounds; ++round) {
+        if (round == warmup) {
+            csw_begin = context_switches_();
+            t_begin = ulat_now_ns();
+        }
+
+        atomic_store_explicit(&fo->fo_n_acked, 0, memory_order_relaxed);
+        fo->fo_stamp = ulat_now_ns();
+        fanout_wake_all_(fo);
+        sem_wait_no_eintr_(&fo->fo_ack_sem);
+
+        if (round >= warmup) {
+            first = fo->fo_woken_ns[0];
+            last = fo->fo_woken_ns[0];
+            for (ix = 1; ix < n; ++ix) {
+                if (fo->fo_woken_ns[ix] < first) {
+                    first = fo->fo_woken_ns[ix];
+                }
+                if (fo->fo_woken_ns[ix] > last) {
+                    last = fo->fo_woken_ns[ix];
+                }
+            }
+            ulat_hist_add(first_hist, first - fo->fo_stamp);
+            ulat_hist_add(all_hist, last - fo->fo_stamp);
+        }
+    }
+    elapsed_ns = ulat_now_ns() - t_begin;
+    *csw_per_round = (double) (context_switches_() - csw_begin) / (double) rounds;
+
+    fo->fo_stop = 1;
+    fanout_wake_all_(fo);
+    for (ix = 0; ix < n; ++ix) {
+        pthread_join(tids[ix], NULL);
+    }
+
+    free(waiters);
+    free(tids);
+
+    return (double) rounds * 1e9 / (double) elapsed_ns;
+}
+
+void
+run_fanout_benchmarks (unsigned long rounds, int n_waiters,
+                       const pthread_mutexattr_t *mutexattr)
+{
+    wb_fanout *fo;
+
+    ulat_hist  first_hist;
+    ulat_hist  all_hist;
+
+    double              rates[WB_N_KINDS];
+    double              csw[WB_N_KINDS];
+    unsigned long long  first_p50[WB_N_KINDS];
+    unsigned long long  all_p50[WB_N_KINDS];
+    unsigned long long  all_p99[WB_N_KINDS];
+
+    int  kind;
+    int  ix;
+
+    fo = aligned_alloc(WB_CACHE_LINE, sizeof *fo);
+    if (NULL == fo) {
+        perror("aligned_alloc(fanout)");
+        exit(55);
+    }
+
+    printf("\n=== One-to-many: %lu rounds, waking %d threads each time\n",
+           rounds, n_waiters);
+
+    for (kind = 0; kind < WB_N_KINDS; ++kind) {
+        memset(fo, 0, sizeof *fo);
+        fo->fo_kind = (wb_kind) kind;
+        fo->fo_n_waiters = n_waiters;
+        fo->fo_n_shards = (n_waiters + WB_SHARD_SIZE - 1) / WB_SHARD_SIZE;
+
+        fo->fo_sems = calloc((size_t) n_waiters, sizeof fo->fo_sems[0]);
+        fo->fo_slots = aligned_alloc(WB_CACHE_LINE, (size_t) n_waiters * sizeof fo->fo_slots[0]);
+        fo->fo_woken_ns = calloc((size_t) n_waiters, sizeof fo->fo_woken_ns[0]);
+        if (NULL == fo->fo_sems || NULL == fo->fo_slots || NULL == fo->fo_woken_ns) {
+            perror("calloc(sems, slots, woken_ns)");
+            exit(56);
+        }
+        for (ix = 0; ix < n_waiters; ++ix) {
+            sem_init(&fo->fo_sems[ix], 0, 0);
+            pthread_mutex_init(&fo->fo_slots[ix].sl_mutex, mutexattr);
+            pthread_cond_init(&fo->fo_slots[ix].sl_cond, NULL);
+            fo->fo_slots[ix].sl_gen = 0;
+        }
+        pthread_mutex_init(&fo->fo_mutex, mutexattr);
+        pthread_cond_init(&fo->fo_cond, NULL);
+        sem_init(&fo->fo_ack_sem, 0, 0);
+        atomic_init(&fo->fo_futex_gen, 0);
+        atomic_init(&fo->fo_n_acked, 0);
+
+        ulat_hist_reset(&first_hist);
+        ulat_hist_reset(&all_hist);
+
+        rates[kind] = run_fanout_(fo, rounds, &first_hist, &all_hist, &csw[kind]);
+
+        printf("%s: %.0f rounds/s, %.1f context switches per round\n",
+               Fanout_Names[kind], rates[kind], csw[kind]);
+        ulat_show_hist(&first_hist, "  first woken:", stdout);
+        ulat_show_hist(&all_hist, "  all woken:", stdout);
+
+        first_p50[kind] = ulat_hist_percentile(&first_hist, 50.0);
+        all_p50[kind] = ulat_hist_percentile(&all_hist, 50.0);
+        all_p99[kind] = ulat_hist_percentile(&all_hist, 99.0);
+
+        sem_destroy(&fo->fo_ack_sem);
+        pthread_cond_destroy(&fo->fo_cond);
+        pthread_mutex_destroy(&fo->fo_mutex);
+        for (ix = 0; ix < n_waiters; ++ix) {
+            pthread_cond_destroy(&fo->fo_slots[ix].sl_cond);
+            pthread_mutex_destroy(&fo->fo_slots[ix].sl_mutex);
+            sem_destroy(&fo->fo_sems[ix]);
+        }
+        free(fo->fo_woken_ns);
+        free(fo->fo_slots);
+        free(fo->fo_sems);
+    }
+
+    printf("\n%-26s %10s %12s %12s %12s %10s\n", "primitive", "rounds/s",
+           "first p50", "all p50", "all p99", "csw/round");
+    for (kind = 0; kind < WB_N_KINDS; ++kind) {
+        printf("%-26s %10.0f %12.3f %12.3f %12.3f %10.1f\n", Fanout_Names[kind], rates[kind],
+               first_p50[kind] / 1e3, all_p50[kind] / 1e3, all_p99[kind] / 1e3, csw[kind]);
+    }
+    printf("(latencies in usec)\n");
+
+    free(fo);
+}
@@ -0,0 +1,37 @@
+/*
+ * demo-code/wakeup-bench.h
+ *
+ * Benchmarks for waking up threads, with semaphores,
+ * condition variables and raw futexes.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <pthread.h>
+
+
+/*
+ * Ping-pong: two threads hand a token back and forth 'round_trips' times;
+ * shows the one-way wakeup latency and the handoff rate for each primitive.
+ *
+ * 'mutexattr' (may be NULL) is used for the mutexes of the condvar cases.
+ */
+void  run_pingpong_benchmarks(unsigned long round_trips,
+                              const pthread_mutexattr_t *mutexattr);
+
+/*
+ * One-to-many: one thread wakes 'n_waiters' threads, 'rounds' times;
+ * each round ends when all the waiters are awake.  Shows the latency
+ * until the first and until the last waiter runs, and the number of
+ * context switches per round (all threads, from getrusage()).
+ *
+ * Besides the ping-pong primitives: a chain of condvars (each woken
+ * waiter wakes the next one), and condvars shared by groups of waiters.
+ */
+void  run_fanout_benchmarks(unsigned long rounds, int n_waiters,
+                            const pthread_mutexattr_t *mutexattr);
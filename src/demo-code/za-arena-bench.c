@@ -0,0 +1,298 @@
+/*
+ * demo-code/za-arena-bench.c
+ *
+ * Many small allocations, freed together: malloc()/free() against
+ * an arena (util-arena), which frees everything with one reset ---
+ * keeping its pages, or giving them back with MADV_DONTNEED.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "util-arena.h"
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define MIN_ALLOC_SIZE  8
+
+static unsigned long  count = 1000000;  /* allocations per round */
+static unsigned long  max_size = 64;
+static unsigned long  rounds = 5;
+static unsigned long  guard_len = 64 * 1024;
+
+typedef enum {
+    BENCH_MALLOC,
+    BENCH_ARENA,          /* reset keeps the pages */
+    BENCH_ARENA_DISCARD,  /* reset with MADV_DONTNEED */
+    BENCH_N_KINDS
+} bench_kind;
+
+static const char *const Kind_Names[BENCH_N_KINDS] = {
+    "malloc/free",
+    "arena",
+    "arena+DONTNEED"
+};
+
+
+static unsigned long
+parse_count_ (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+    unsigned long  factor = 1;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(11);
+    }
+
+    /* Optional suffix for sizes: K = KiB, M = MiB */
+    if ('k' == *end || 'K' == *end) {
+        factor = 1024;
+        ++end;
+    } else if ('m' == *end || 'M' == *end) {
+        factor = 1024 * 1024;
+        ++end;
+    }
+
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+    if (value > ULONG_MAX / factor) {
+        fprintf(stderr, "%s '%s' is too large.\n",
+                what, data);
+        exit(2);
+    }
+
+    return value * factor;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    if (0 == strncmp("count:", arg, 6)) {
+        count = parse_count_(arg + 6, "count");
+    }
+    else if (0 == strncmp("size:", arg, 5)) {
+        max_size = parse_count_(arg + 5, "size");
+    }
+    else if (0 == strncmp("rounds:", arg, 7)) {
+        rounds = parse_count_(arg + 7, "rounds");
+    }
+    else if (0 == strncmp("guard:", arg, 6)) {
+        guard_len = parse_count_(arg + 6, "guard");
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [count:<N>] [size:<Bytes>] [rounds:<N>] [guard:<Bytes>]\n");
+    fprintf(out_stream, "  Each round allocates N objects (default 1000000) of %d to 'size'\n"
+            "  bytes (default 64), writes to each, then frees them all (or resets\n"
+            "  the arena).  'guard:' is the arena guard (default 64K, may be 0).\n",
+            MIN_ALLOC_SIZE);
+}
+
+
+/*
+ * Same sizes for all kinds: xorshift from the same seed.
+ */
+static size_t
+next_size_ (uint32_t *state)
+{
+    uint32_t  x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return MIN_ALLOC_SIZE + x % (max_size - MIN_ALLOC_SIZE + 1);
+}
+
+static long
+minor_faults_ (void)
+{
+    struct rusage  ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        perror("getrusage()");
+        return 0;
+    }
+
+    return ru.ru_minflt;
+}
+
+static int
+run_kind_ (bench_kind kind, uar_arena *ar, char **ptrs)
+{
+    unsigned long long  alloc_ns = 0;
+    unsigned long long  free_ns = 0;
+    unsigned long long  t_begin;
+
+    uint32_t  size_state;
+
+    long  faults_begin;
+
+    unsigned long  round;
+    unsigned long  ix;
+
+    size_t  size;
+
+    faults_begin = minor_faults_();
+
+    for (round = 0; round < rounds; ++round) {
+        size_state = 2463534242u;
+
+        t_begin = ulat_now_ns();
+        for (ix = 0; ix < count; ++ix) {
+            size = next_size_(&size_state);
+            ptrs[ix] = (BENCH_MALLOC == kind) ? malloc(size) : uar_alloc(ar, size);
+            if (NULL == ptrs[ix]) {
+                fprintf(stderr, "%s: allocation %lu (%zu bytes) failed\n",
+                        Kind_Names[kind], ix, size);
+                return 21;
+            }
+            ptrs[ix][0] = (char) ix;
+            ptrs[ix][size - 1] = (char) ix;
+        }
+        alloc_ns += ulat_now_ns() - t_begin;
+
+        t_begin = ulat_now_ns();
+        if (BENCH_MALLOC == kind) {
+            for (ix = 0; ix < count; ++ix) {
+                free(ptrs[ix]);
+            }
+        } else {
+            uar_reset(ar, BENCH_ARENA_DISCARD == kind);
+        }
+        free_ns += ulat_now_ns() - t_begin;
+    }
+
+    printf("%-16s %10.1f %12.2f %14.0f %12.1f\n", Kind_Names[kind],
+           (double) alloc_ns / ((double) count * rounds),
+           (double) free_ns / ((double) count * rounds),
+           (double) (minor_faults_() - faults_begin) / rounds,
+           (double) (alloc_ns + free_ns) / 1e6 / rounds);
+
+    return 0;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    uar_arena  arena;
+
+    char **ptrs;
+
+    int  kind;
+    int  arg_pos;
+    int  res;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg_(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+    if (0 == count || 0 == rounds || max_size < MIN_ALLOC_SIZE) {
+        fprintf(stderr, "Need count and rounds above 0, size at least %d.\n",
+                MIN_ALLOC_SIZE);
+        return 2;
+    }
+
+    /* Room for the worst case: every object of 'max_size', padded. */
+    if (max_size > (SIZE_MAX - UAR_DEFAULT_ALIGN) / count
+        || count > SIZE_MAX / sizeof *ptrs) {
+        fprintf(stderr, "count %lu times size %lu is too large for the address space.\n",
+                count, max_size);
+        return 2;
+    }
+
+    ptrs = malloc(count * sizeof *ptrs);
+    if (NULL == ptrs) {
+        perror("malloc(pointers)");
+        return 3;
+    }
+
+    res = uar_init(&arena, count * (max_size + UAR_DEFAULT_ALIGN), guard_len);
+    if (res != 0) {
+        return 4;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("%lu rounds of %lu allocations, %d to %lu bytes.\n",
+           rounds, count, MIN_ALLOC_SIZE, max_size);
+    printf("%-16s %10s %12s %14s %12s\n", "allocator", "ns/alloc",
+           "ns/free", "minflt/round", "ms/round");
+
+    for (kind = 0; kind < BENCH_N_KINDS; ++kind) {
+        res = run_kind_((bench_kind) kind, &arena, ptrs);
+        if (res != 0) {
+            return res;
+        }
+    }
+
+    uar_show_stats(&arena, "[arena]", stdout);
+
+    uar_destroy(&arena);
+    free(ptrs);
+
+    return 0;
+}
@@ -38,7 +38,9 @@ parse_sa_flags_str (const char *data)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [sa_flags=...]\n");
+    fprintf(out_stream, "Usage: [sa_flags=...] [trace]\n");
+    fprintf(out_stream, "  'trace': the handlers record each signal in a lock-free ring,\n"
+            "  the loop shows them (with si_code, si_pid and sival_int if 'i' = SA_SIGINFO).\n");
     show_all_sigaction_flags(out_stream);
 }
 
@@ -51,21 +53,32 @@ int
 main (int argc, char* argv[])
 {
     int  sigact_flags = SA_RESTART;
+    int  arg_pos = 1;
 
     const char *data;
 
-    if (argc == 2) {
-        if (0 == strncmp("sa_flags=", argv[1], 9)) {
-            data = argv[1] + 9;
+    if (arg_pos < argc) {
+        if (0 == strncmp("sa_flags=", argv[arg_pos], 9)) {
+            data = argv[arg_pos] + 9;
             sigact_flags = parse_sa_flags_str(data);
-        } else {
-            fprintf(stderr, "Unrecognized argument '%s'.\n",
-                    argv[1]);
-            show_usage(stderr);
-            exit(2);
+            ++arg_pos;
         }
     }
 
+    if (arg_pos < argc) {
+        if (0 == strcmp("trace", argv[arg_pos])) {
+            enable_loop_err_trace();
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        fprintf(stderr, "Unrecognized argument '%s'.\n",
+                argv[arg_pos]);
+        show_usage(stderr);
+        exit(2);
+    }
+
     printf("Pid = %ld\n", (long) getpid());
     printf("SIGRTMIN = %d, SIGRTMAX = %d\n", SIGRTMIN, SIGRTMAX);
 
@@ -17,8 +17,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include "loop-reading.h"
 #include "util-ofd-flags.h"
 #include "util-timeval.h"
 
@@ -149,6 +152,63 @@ parse_uint_ (const char *const data)
     return (unsigned) ul_val;
 }
 
+/*
+ * Size in bytes, with an optional suffix: K = KiB, M = MiB.
+ */
+static size_t
+parse_size_ (const char *const data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  ul_val;
+    unsigned long  factor = 1;
+
+    errno = 0;
+    ul_val = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse size '%s'\n",
+                data);
+        exit(15);
+    }
+    if ('k' == *end || 'K' == *end) {
+        factor = 1024;
+        ++end;
+    } else if ('m' == *end || 'M' == *end) {
+        factor = 1024 * 1024;
+        ++end;
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after size %lu\n",
+                end, ul_val);
+        exit(16);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing size '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(17);
+    }
+
+    /* Checked before multiplying: a wrapped product could pass. */
+    if (ul_val > INT_MAX / factor) {
+        fprintf(stderr, "Size must be between 1 and %d (original text was '%s')\n",
+                INT_MAX, data);
+        exit(18);
+    }
+    ul_val *= factor;
+
+    if (0 == ul_val || ul_val > INT_MAX) {
+        fprintf(stderr, "Size must be between 1 and %d (got %lu, original text was '%s')\n",
+                INT_MAX, ul_val, data);
+        exit(18);
+    }
+
+    return (size_t) ul_val;
+}
+
 static double
 parse_delay_ (const char *const data)
 {
@@ -195,6 +255,43 @@ static unsigned  alarm_s = 0;
 
 static double  delay_s = 2.4;
 
+/*
+ * The classic engine reads once per cycle, with alarm() for timeout,
+ * then sleeps; the others drain the input until EOF and show statistics.
+ */
+typedef enum {
+    ENGINE_CLASSIC,
+    ENGINE_BLOCKING,  /* blocking read() until EOF, no delay */
+    ENGINE_EPOLL,
+    ENGINE_URING,
+    ENGINE_SPLICE     /* splice() to an output fd, no copy to user memory */
+} read_engine;
+
+static read_engine  engine = ENGINE_CLASSIC;
+
+static unsigned  uring_depth = 4;  /* reads in flight */
+
+static size_t  bufsize = 1024;
+
+/* splice engine: where the data goes, and where a copy goes (tee) */
+static const char *out_path = "/dev/null";
+static const char *tee_path = NULL;
+
+static int  out_fd = -1;
+static int  tee_fd = -1;
+
+/*
+ * Sweep: the same engine (blocking read() for the classic one) with
+ * buffer sizes from SWEEP_BUFSIZE_MIN to SWEEP_BUFSIZE_MAX, doubling.
+ * A regular file on stdin is read again for each size; otherwise
+ * a child process writes 'sweep_mib' MiB into a pipe for each size.
+ */
+#define SWEEP_BUFSIZE_MIN  512
+#define SWEEP_BUFSIZE_MAX  (1024 * 1024)
+
+static int       want_sweep = 0;
+static unsigned  sweep_mib = 256;
+
 /*
  * Handle Argument (usually coming from command-line interface).
  * This function handles one argument, but it can be any of the legal arguments.
@@ -220,6 +317,40 @@ handle_arg_ (const char *arg)
     else if (0 == strcmp("nonblocking", arg)) {
         set_ofd_status_flags(STDIN_FILENO, O_NONBLOCK);
     }
+    else if (0 == strcmp("drain", arg)) {
+        engine = ENGINE_BLOCKING;
+    }
+    else if (0 == strcmp("epoll", arg)) {
+        engine = ENGINE_EPOLL;
+    }
+    else if (0 == strcmp("uring", arg)) {
+        engine = ENGINE_URING;
+    }
+    else if (0 == strcmp("splice", arg)) {
+        engine = ENGINE_SPLICE;
+    }
+    else if (0 == strncmp("out:", arg, 4)) {
+        out_path = arg + 4;
+    }
+    else if (0 == strncmp("tee:", arg, 4)) {
+        tee_path = arg + 4;
+    }
+    else if (0 == strncmp("depth:", arg, 6)) {
+        data = arg + 6;
+        uring_depth = parse_uint_(data);
+    }
+    else if (0 == strncmp("bufsize:", arg, 8)) {
+        data = arg + 8;
+        bufsize = parse_size_(data);
+    }
+    else if (0 == strcmp("sweep", arg)) {
+        want_sweep = 1;
+    }
+    else if (0 == strncmp("sweep:", arg, 6)) {
+        data = arg + 6;
+        want_sweep = 1;
+        sweep_mib = parse_uint_(data);
+    }
     else {
         return -1;
     }
@@ -231,7 +362,268 @@ handle_arg_ (const char *arg)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [alarm:<Seconds>] [delay:<Seconds_with_decimals>] [nonblocking]\n");
+    fprintf(out_stream, "Usage: [alarm:<Seconds>] [delay:<Seconds_with_decimals>] [nonblocking]"
+            " [drain|epoll|uring [depth:<N>]|splice [out:<Path>] [tee:<Path>]]"
+            " [bufsize:<Bytes>] [sweep[:<MiB>]]\n");
+    fprintf(out_stream, "  'splice' moves the input to 'out:' (default /dev/null) with splice(),\n"
+            "           and a copy to 'tee:' with tee(), without reading it;\n"
+            "           with 'sweep', each size is also run with read() for comparison.\n");
+    fprintf(out_stream, "  'bufsize:' read size (default 1024), may have a K or M suffix.\n"
+            "  'sweep': buffer sizes from %d bytes to %d KiB, with the chosen engine\n"
+            "           (or 'drain'); rereads a regular file on stdin, or else\n"
+            "           reads MiB (default 256) of generated data from a pipe.\n",
+            SWEEP_BUFSIZE_MIN, SWEEP_BUFSIZE_MAX / 1024);
+    fprintf(out_stream, "  'drain': blocking read() until EOF, then show throughput statistics.\n"
+            "  'epoll': same, but O_NONBLOCK reads until EAGAIN, waiting with epoll_wait();\n"
+            "           'alarm:' becomes the epoll_wait() timeout (needs a pipe, FIFO, tty...).\n"
+            "  'uring': same, with io_uring: N reads in flight (default 4), registered buffers;\n"
+            "           'alarm:' becomes a timeout linked to each read.\n");
+}
+
+static int
+run_engine_once_ (read_engine eng, int fd, char *buf, size_t size, read_stats *rs)
+{
+    /* Clamped: INT_MAX ms is about 24.8 days. */
+    const int  timeout_ms = (0 == alarm_s) ? -1
+                          : (alarm_s > INT_MAX / 1000) ? INT_MAX
+                          : (int) (alarm_s * 1000);
+
+    memset(rs, 0, sizeof *rs);
+
+    switch (eng) {
+    case ENGINE_EPOLL:
+        return loop_reading_epoll(fd, buf, size, timeout_ms, rs);
+    case ENGINE_URING:
+        return loop_reading_uring(fd, size, uring_depth, timeout_ms, rs);
+    case ENGINE_SPLICE:
+        /* Seekable outputs are rewritten by each run of a sweep. */
+        (void) lseek(out_fd, 0, SEEK_SET);
+        if (tee_fd >= 0) {
+            (void) lseek(tee_fd, 0, SEEK_SET);
+        }
+        return loop_reading_splice(fd, out_fd, tee_fd, size, rs);
+    default:
+        return loop_reading_blocking(fd, buf, size, rs);
+    }
+}
+
+static const char *
+engine_preamble_ (read_engine eng)
+{
+    switch (eng) {
+    case ENGINE_EPOLL:
+        return "[epoll]";
+    case ENGINE_URING:
+        return "[uring]";
+    case ENGINE_SPLICE:
+        return "[splice]";
+    default:
+        return "[read]";
+    }
+}
+
+static int
+run_engine_ (char *buf)
+{
+    read_stats  rs;
+
+    int  res;
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("Reading from fd %d until EOF, %zu bytes at a time...\n",
+           STDIN_FILENO, bufsize);
+
+    res = run_engine_once_(engine, STDIN_FILENO, buf, bufsize, &rs);
+    show_read_stats(&rs, engine_preamble_(engine), stdout);
+
+    return (0 == res) ? 0 : 6;
+}
+
+/*
+ * Returns the read end of a pipe, with a child process writing
+ * 'sweep_mib' MiB of zeroes into the write end.
+ */
+static int
+start_pipe_writer_ (pid_t *child_pid)
+{
+    static char  wbuf[64 * 1024];
+
+    unsigned long long  remaining = (unsigned long long) sweep_mib * 1024 * 1024;
+
+    ssize_t  num_written;
+
+    int  pipe_fds[2];
+
+    if (pipe(pipe_fds) < 0) {
+        perror("pipe()");
+        exit(7);
+    }
+
+    *child_pid = fork();
+    if (*child_pid < 0) {
+        perror("fork()");
+        exit(8);
+    }
+
+    if (0 == *child_pid) {
+        close(pipe_fds[0]);
+        while (remaining > 0) {
+            num_written = write(pipe_fds[1], wbuf,
+                                (remaining < sizeof wbuf) ? (size_t) remaining : sizeof wbuf);
+            if (num_written < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                _exit(1);
+            }
+            remaining -= (unsigned long long) num_written;
+        }
+        _exit(0);
+    }
+
+    close(pipe_fds[1]);
+
+    return pipe_fds[0];
+}
+
+/*
+ * For the splice engine.
+ */
+static int
+open_output_ (const char *path)
+{
+    const int  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "Could not open '%s' for writing: errno %d = %s\n",
+                path, errno, strerror(errno));
+        exit(9);
+    }
+
+    return fd;
+}
+
+static int
+run_sweep_ (void)
+{
+    struct stat  st;
+
+    /* with splice, each size is also run with read(): 'baseline' */
+    read_stats  baseline[32];
+    read_stats  results[32];
+    size_t      sizes[32];
+
+    read_engine  eng;
+
+    char *buf;
+
+    const double  mib_factor = 1024.0 * 1024.0;
+
+    pid_t  child_pid = -1;
+
+    size_t  size;
+
+    const int  compare = (ENGINE_SPLICE == engine);
+
+    int  n_sizes = 0;
+    int  from_file;
+    int  fd;
+    int  res = 0;
+    int  pass;
+    int  ix;
+
+    if (fstat(STDIN_FILENO, &st) < 0) {
+        perror("fstat(STDIN_FILENO)");
+        return 6;
+    }
+    from_file = S_ISREG(st.st_mode);
+
+    buf = malloc(SWEEP_BUFSIZE_MAX);
+    if (NULL == buf) {
+        perror("malloc(sweep buffer)");
+        return 3;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    if (from_file) {
+        printf("Reading the file on fd %d (%lld bytes) for each buffer size, with %s\n",
+               STDIN_FILENO, (long long) st.st_size, engine_preamble_(engine));
+    } else {
+        printf("Reading %u MiB from a pipe for each buffer size, with %s\n",
+               sweep_mib, engine_preamble_(engine));
+    }
+
+    for (size = SWEEP_BUFSIZE_MIN; size <= SWEEP_BUFSIZE_MAX && 0 == res; size *= 2) {
+        sizes[n_sizes] = size;
+
+        for (pass = compare ? 0 : 1; pass < 2; ++pass) {
+            eng = (0 == pass) ? ENGINE_BLOCKING : engine;
+
+            if (from_file) {
+                if (lseek(STDIN_FILENO, 0, SEEK_SET) < 0) {
+                    perror("lseek(STDIN_FILENO)");
+                    res = 6;
+                    break;
+                }
+                fd = STDIN_FILENO;
+            } else {
+                fd = start_pipe_writer_(&child_pid);
+            }
+
+            res = run_engine_once_(eng, fd, buf, size,
+                                   (0 == pass) ? &baseline[n_sizes] : &results[n_sizes]);
+
+            if (!from_file) {
+                close(fd);  /* the writer gets SIGPIPE if we stopped early */
+                waitpid(child_pid, NULL, 0);
+            }
+            if (res != 0) {
+                res = 6;
+                break;
+            }
+        }
+        if (0 == res) {
+            ++n_sizes;
+        }
+    }
+
+    if (compare) {
+        printf("\n%10s %12s %12s %8s %14s\n", "bufsize", "read MB/s", "splice MB/s",
+               "ratio", "syscalls/MiB");
+        for (ix = 0; ix < n_sizes; ++ix) {
+            const double  read_mbps = (double) baseline[ix].rs_bytes * 1e3
+                                      / (double) baseline[ix].rs_elapsed_ns;
+            const double  splice_mbps = (double) results[ix].rs_bytes * 1e3
+                                        / (double) results[ix].rs_elapsed_ns;
+
+            printf("%10zu %12.1f %12.1f %8.2f %14.1f\n", sizes[ix],
+                   read_mbps, splice_mbps, splice_mbps / read_mbps,
+                   (results[ix].rs_bytes > 0)
+                   ? (double) results[ix].rs_syscalls * mib_factor / (double) results[ix].rs_bytes
+                   : 0.0);
+        }
+
+        free(buf);
+
+        return res;
+    }
+
+    printf("\n%10s %10s %12s %12s %14s\n", "bufsize", "MB/s", "reads/s",
+           "bytes/read", "syscalls/MiB");
+    for (ix = 0; ix < n_sizes; ++ix) {
+        const read_stats *const  rs = &results[ix];
+        const double  seconds = (double) rs->rs_elapsed_ns / 1e9;
+
+        printf("%10zu %10.1f %12.0f %12.0f %14.1f\n", sizes[ix],
+               (double) rs->rs_bytes / 1e6 / seconds,
+               (double) rs->rs_reads / seconds,
+               (rs->rs_reads > 0) ? (double) rs->rs_bytes / (double) rs->rs_reads : 0.0,
+               (rs->rs_bytes > 0) ? (double) rs->rs_syscalls * mib_factor / (double) rs->rs_bytes : 0.0);
+    }
+
+    free(buf);
+
+    return res;
 }
 
 int
@@ -241,7 +633,7 @@ main (int argc, char* argv[])
 
     struct timeval  delay_tval;
 
-    char  buf[1024];
+    char *buf;
 
     int      num_read;
     errno_t  read_err;
@@ -261,6 +653,27 @@ main (int argc, char* argv[])
         }
     }
 
+    if (ENGINE_SPLICE == engine) {
+        out_fd = open_output_(out_path);
+        if (tee_path != NULL) {
+            tee_fd = open_output_(tee_path);
+        }
+    }
+
+    if (want_sweep) {
+        return run_sweep_();
+    }
+
+    buf = malloc(bufsize);
+    if (NULL == buf) {
+        perror("malloc(buf)");
+        return 3;
+    }
+
+    if (engine != ENGINE_CLASSIC) {
+        return run_engine_(buf);
+    }
+
     /* We must override the default disposition for SIGALRM,
      * which is to terminate the process (therefore our read loop).
      *
@@ -300,13 +713,13 @@ main (int argc, char* argv[])
                    STDIN_FILENO);
         }
 
-        num_read = read(STDIN_FILENO, buf, sizeof buf);
+        num_read = read(STDIN_FILENO, buf, bufsize);
         read_err = errno;
 
         alarm_rem = alarm(0);  /* Cancel the pending alarm request, if any. */
 
         printf("read(STDIN_FILENO, buf, %zu) returned %d, errno %d = %s\n",
-               sizeof buf, num_read, read_err, strerror(read_err));
+               bufsize, num_read, read_err, strerror(read_err));
 
         if (alarm_s > 0) {
             printf("Canceled alarm: %u seconds remaining out of %u requested.\n",
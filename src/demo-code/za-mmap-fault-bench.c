@@ -0,0 +1,337 @@
+/*
+ * demo-code/za-mmap-fault-bench.c
+ *
+ * First-touch page fault cost of a large mapping, made four ways:
+ * MAP_PRIVATE of /dev/zero (as in za-mmap-split-merge), MAP_ANONYMOUS,
+ * MAP_ANONYMOUS | MAP_POPULATE, and MAP_SHARED of a memfd.
+ * Touched by one thread, then by N threads with disjoint slices
+ * of the same mapping: all their faults take the mmap_lock (for reading,
+ * or the per-VMA lock on newer kernels) of the one address space.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _GNU_SOURCE  /* for memfd_create(), MAP_ANONYMOUS, MAP_POPULATE */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define THREADS_MAX  256
+
+static unsigned long  size_mib = 1024;
+static unsigned long  n_threads = 4;
+
+typedef enum {
+    FAULT_DEV_ZERO,
+    FAULT_ANON,
+    FAULT_POPULATE,
+    FAULT_MEMFD,
+    FAULT_N_KINDS
+} fault_kind;
+
+static const char *const Kind_Names[FAULT_N_KINDS] = {
+    "/dev/zero private",
+    "anonymous",
+    "anon+MAP_POPULATE",
+    "memfd shared"
+};
+
+typedef struct {
+    pthread_barrier_t *tt_start;
+
+    volatile char *tt_begin;
+    size_t         tt_len;
+    size_t         tt_page_size;
+} touch_thread_arg;
+
+
+static unsigned long
+parse_count_ (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(11);
+    }
+
+    /* Optional suffix for sizes (in MiB): G = GiB */
+    if ('g' == *end || 'G' == *end) {
+        value *= 1024;
+        ++end;
+    }
+
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+    if (0 == value) {
+        fprintf(stderr, "The %s must be above 0.\n", what);
+        exit(14);
+    }
+
+    return value;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    if (0 == strncmp("size:", arg, 5)) {
+        size_mib = parse_count_(arg + 5, "size");
+    }
+    else if (0 == strncmp("threads:", arg, 8)) {
+        n_threads = parse_count_(arg + 8, "thread count");
+        if (n_threads > THREADS_MAX) {
+            fprintf(stderr, "At most %d threads.\n", THREADS_MAX);
+            exit(15);
+        }
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [size:<MiB>] [threads:<N>]\n");
+    fprintf(out_stream, "  Maps 'size' MiB (default 1024; a G suffix means GiB) in each way,\n"
+            "  writes one byte per page with 1 thread, then with N threads\n"
+            "  (default 4) on disjoint slices; shows mmap(), touch and munmap() times.\n");
+}
+
+
+static long
+minor_faults_ (void)
+{
+    struct rusage  ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        perror("getrusage()");
+        return 0;
+    }
+
+    return ru.ru_minflt;
+}
+
+static void *
+touch_thread_ (void *arg)
+{
+    const touch_thread_arg *const  tt = arg;
+
+    size_t  pos;
+
+    pthread_barrier_wait(tt->tt_start);
+
+    for (pos = 0; pos < tt->tt_len; pos += tt->tt_page_size) {
+        tt->tt_begin[pos] = 1;
+    }
+
+    return NULL;
+}
+
+static void *
+map_ (fault_kind kind, size_t len)
+{
+    void *addr = MAP_FAILED;
+
+    int  fd = -1;
+
+    switch (kind) {
+    case FAULT_DEV_ZERO:
+        fd = open("/dev/zero", O_RDWR | O_CLOEXEC);
+        if (fd >= 0) {
+            addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        }
+        break;
+    case FAULT_ANON:
+        addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        break;
+    case FAULT_POPULATE:
+        addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        break;
+    case FAULT_MEMFD:
+        fd = memfd_create("za-mmap-fault-bench", MFD_CLOEXEC);
+        if (fd >= 0 && ftruncate(fd, (off_t) len) == 0) {
+            addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (MAP_FAILED == addr) {
+        fprintf(stderr, "%s: mapping %zu bytes failed: errno %d = %s\n",
+                Kind_Names[kind], len, errno, strerror(errno));
+    }
+    if (fd >= 0) {
+        close(fd);  /* the mapping keeps the file */
+    }
+
+    return (MAP_FAILED == addr) ? NULL : addr;
+}
+
+static int
+run_one_ (fault_kind kind, size_t len, unsigned long threads)
+{
+    pthread_t          tids[THREADS_MAX];
+    touch_thread_arg   args[THREADS_MAX];
+    pthread_barrier_t  start;
+
+    const size_t  page_size = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t  n_pages = len / page_size;
+    const size_t  slice_pages = n_pages / threads;
+
+    unsigned long long  t_begin;
+    unsigned long long  map_ns;
+    unsigned long long  touch_ns;
+    unsigned long long  unmap_ns;
+
+    long  faults_begin;
+    long  faults;
+
+    char *base;
+
+    unsigned long  ix;
+
+    errno_t  err;
+
+    faults_begin = minor_faults_();
+
+    t_begin = ulat_now_ns();
+    base = map_(kind, len);
+    map_ns = ulat_now_ns() - t_begin;
+    if (NULL == base) {
+        return 21;
+    }
+
+    pthread_barrier_init(&start, NULL, (unsigned) threads + 1);
+    for (ix = 0; ix < threads; ++ix) {
+        args[ix].tt_start = &start;
+        args[ix].tt_begin = base + ix * slice_pages * page_size;
+        args[ix].tt_len = ((ix + 1 == threads) ? n_pages - ix * slice_pages : slice_pages)
+                          * page_size;
+        args[ix].tt_page_size = page_size;
+
+        err = pthread_create(&tids[ix], NULL, touch_thread_, &args[ix]);
+        if (err != 0) {
+            fprintf(stderr, "pthread_create() failed: errno %d = %s\n",
+                    err, strerror(err));
+            exit(22);
+        }
+    }
+
+    pthread_barrier_wait(&start);
+    t_begin = ulat_now_ns();
+    for (ix = 0; ix < threads; ++ix) {
+        pthread_join(tids[ix], NULL);
+    }
+    touch_ns = ulat_now_ns() - t_begin;
+    pthread_barrier_destroy(&start);
+
+    faults = minor_faults_() - faults_begin;
+
+    t_begin = ulat_now_ns();
+    munmap(base, len);
+    unmap_ns = ulat_now_ns() - t_begin;
+
+    printf("%-18s %7lu %10.1f %10.1f %10.1f %12ld %10.1f\n", Kind_Names[kind],
+           threads, (double) map_ns / 1e6, (double) touch_ns / 1e6,
+           (double) unmap_ns / 1e6, faults,
+           (double) (map_ns + touch_ns) / (double) n_pages);
+
+    return 0;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    size_t  len;
+
+    int  kind;
+    int  arg_pos;
+    int  res;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg_(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+
+    len = (size_t) size_mib * 1024 * 1024;
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("%lu MiB per mapping, %ld online CPUs.\n",
+           size_mib, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-18s %7s %10s %10s %10s %12s %10s\n", "mapping", "threads",
+           "mmap ms", "touch ms", "munmap ms", "minflt", "ns/page");
+
+    for (kind = 0; kind < FAULT_N_KINDS; ++kind) {
+        res = run_one_((fault_kind) kind, len, 1);
+        if (0 == res && n_threads > 1) {
+            res = run_one_((fault_kind) kind, len, n_threads);
+        }
+        if (res != 0) {
+            return res;
+        }
+    }
+
+    return 0;
+}
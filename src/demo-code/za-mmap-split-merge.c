@@ -8,13 +8,32 @@
  *  if you want to)
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include "mmap-hugepages.h"
+#include "mmap-userfault.h"
 #include "util-input.h"
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
 
 
 /*
@@ -141,13 +160,317 @@ mprotect_range_ (const mem_range *mr, int prot)
 }
 
 
+/*
+ * Companion mode, not interactive: large regions with huge pages
+ * (see mmap-hugepages.c).  Zero = the split/merge demonstration.
+ */
+static unsigned  huge_mib = 0;
+
+static unsigned  huge_stride = 4096;
+
+/*
+ * Automated split/merge, not interactive: every other unit of an area
+ * of this many units is made read-only, one unit at a time, so the number
+ * of VMAs grows by two with each mprotect().  Zero = not wanted.
+ */
+static unsigned  stress_units = 0;
+
+/*
+ * Lazy population, not interactive: the test area gets this many units
+ * and its pages are supplied through userfaultfd (see mmap-userfault.c).
+ * Zero = not wanted.
+ */
+static unsigned  uffd_units = 0;
+static unsigned  uffd_batch = 1;  /* pages per fault */
+
+static const char *uffd_backing_path = NULL;
+
+/* mmap() + munmap() pairs timed at each step, as a probe */
+#define STRESS_PROBES  32
+
+
+/*
+ * Lines in /proc/self/maps = VMAs of this process.
+ */
+static long
+count_maps_lines_ (void)
+{
+    char  line[512];
+
+    FILE *maps = fopen("/proc/self/maps", "r");
+
+    long  n_lines = 0;
+
+    if (NULL == maps) {
+        perror("fopen(/proc/self/maps)");
+        return -1;
+    }
+    while (fgets(line, sizeof line, maps) != NULL) {
+        if (strchr(line, '\n') != NULL) {
+            ++n_lines;
+        }
+    }
+    fclose(maps);
+
+    return n_lines;
+}
+
+/*
+ * Average ns of an unrelated mmap() + munmap() of one page:
+ * the cost of finding a gap and inserting/removing a VMA.
+ */
+static double
+probe_mmap_ns_ (void)
+{
+    const unsigned long long  t_begin = ulat_now_ns();
+
+    void *addr;
+
+    int  ix;
+
+    for (ix = 0; ix < STRESS_PROBES; ++ix) {
+        addr = mmap(NULL, 4096, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, mapped_fd, 0);
+        if (MAP_FAILED == addr) {
+            perror("mmap(probe)");
+            exit(31);
+        }
+        munmap(addr, 4096);
+    }
+
+    return (double) (ulat_now_ns() - t_begin) / STRESS_PROBES;
+}
+
+static void
+run_vma_stress_once_ (unsigned n_units)
+{
+    mem_range  area;
+    mem_range  unit;
+
+    unsigned long long  t_mprotect = 0;
+    unsigned long long  t_fault = 0;
+    unsigned long long  t_begin;
+
+    const long  maps_at_start = count_maps_lines_();
+    long        maps_split;
+    long        maps_remapped;
+
+    unsigned  n_done = 0;  /* read-only units */
+    unsigned  n_batch = 0;
+    unsigned  next_report = 16;
+    unsigned  ix;
+
+    area.m_unit_offset = 0;
+    area.m_fd_offset = 0;
+    area.m_len = (size_t) n_units * Mem_Map_Unit;
+    area.m_base_addr = mmap(0, area.m_len, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE, mapped_fd, area.m_fd_offset);
+    if (MAP_FAILED == area.m_base_addr) {
+        perror("mmap(stress area)");
+        exit(32);
+    }
+
+    printf("\nwant_offset_adjust = %d: %u units of %zu KiB, %ld VMAs at start.\n",
+           want_offset_adjust, n_units, Mem_Map_Unit / 1024, maps_at_start);
+    printf("%10s %10s %14s %16s %12s\n", "read-only", "VMAs",
+           "mprotect ns", "mmap+munmap ns", "fault ns");
+
+    /* Split: odd units read-only; first touch of the even ones. */
+    for (ix = 1; ix < n_units; ix += 2) {
+        fill_subrange_(&unit, &area, ix, 1);
+
+        t_begin = ulat_now_ns();
+        if (mprotect(unit.m_base_addr, unit.m_len, PROT_READ) != 0) {
+            perror("mprotect");
+            exit(33);
+        }
+        t_mprotect += ulat_now_ns() - t_begin;
+
+        t_begin = ulat_now_ns();
+        *((volatile char *) unit.m_base_addr - Mem_Map_Unit) = 1;
+        t_fault += ulat_now_ns() - t_begin;
+
+        ++n_done;
+        ++n_batch;
+        if (n_done == next_report || ix + 2 >= n_units) {
+            printf("%10u %10ld %14.0f %16.0f %12.0f\n", n_done, count_maps_lines_(),
+                   (double) t_mprotect / n_batch, probe_mmap_ns_(),
+                   (double) t_fault / n_batch);
+            t_mprotect = t_fault = 0;
+            n_batch = 0;
+            next_report *= 2;
+        }
+    }
+    maps_split = count_maps_lines_();
+
+    /*
+     * Merge back: map the read-only units again, writable.
+     * Even with the right file offsets, a unit merges only with its
+     * previous neighbor: the even units were first touched after the split,
+     * so each got its own anon_vma, and VMAs with different anon_vmas
+     * cannot be merged.  Untouched, they would all merge back.
+     */
+    t_begin = ulat_now_ns();
+    for (ix = 1; ix < n_units; ix += 2) {
+        fill_subrange_(&unit, &area, ix, 1);
+        if (mmap(unit.m_base_addr, unit.m_len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_FIXED, mapped_fd, unit.m_fd_offset) != unit.m_base_addr) {
+            perror("mmap(... MAP_FIXED ...)");
+            exit(34);
+        }
+    }
+    maps_remapped = count_maps_lines_();
+    printf("Mapped %u units again, writable: %.0f ns per mmap(MAP_FIXED);"
+           " VMAs %ld -> %ld (%s).\n",
+           n_done, (double) (ulat_now_ns() - t_begin) / n_done,
+           maps_split, maps_remapped,
+           (maps_remapped <= maps_at_start + 1) ? "merged back"
+           : (maps_remapped < maps_split) ? "partly merged" : "NOT merged");
+
+    /* Tear down, one unit at a time, from the end. */
+    t_begin = ulat_now_ns();
+    for (ix = n_units; ix-- > 0; ) {
+        fill_subrange_(&unit, &area, ix, 1);
+        if (munmap(unit.m_base_addr, unit.m_len) != 0) {
+            perror("munmap");
+            exit(35);
+        }
+    }
+    printf("Unmapped %u units: %.0f ns per munmap.\n",
+           n_units, (double) (ulat_now_ns() - t_begin) / n_units);
+}
+
+
+static unsigned
+parse_uint_ (const char *const data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  ul_val;
+
+    errno = 0;
+    ul_val = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse number '%s'\n",
+                data);
+        exit(21);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after number %lu\n",
+                end, ul_val);
+        exit(22);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing number '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(23);
+    }
+
+    if (0 == ul_val || ul_val > UINT_MAX) {
+        fprintf(stderr, "Number must be between 1 and %u (got %lu, original text was '%s')\n",
+                UINT_MAX, ul_val, data);
+        exit(24);
+    }
+
+    return (unsigned) ul_val;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    const char *data;
+
+    if (0 == strcmp("huge", arg)) {
+        huge_mib = 256;
+    }
+    else if (0 == strncmp("huge:", arg, 5)) {
+        data = arg + 5;
+        huge_mib = parse_uint_(data);
+    }
+    else if (0 == strcmp("vma-stress", arg)) {
+        stress_units = 8192;
+    }
+    else if (0 == strncmp("vma-stress:", arg, 11)) {
+        data = arg + 11;
+        stress_units = parse_uint_(data);
+    }
+    else if (0 == strcmp("uffd", arg)) {
+        uffd_units = 1024;
+    }
+    else if (0 == strncmp("uffd:", arg, 5)) {
+        data = arg + 5;
+        uffd_units = parse_uint_(data);
+    }
+    else if (0 == strncmp("uffd-batch:", arg, 11)) {
+        data = arg + 11;
+        uffd_batch = parse_uint_(data);
+    }
+    else if (0 == strncmp("uffd-from:", arg, 10)) {
+        uffd_backing_path = arg + 10;
+    }
+    else if (0 == strncmp("stride:", arg, 7)) {
+        data = arg + 7;
+        huge_stride = parse_uint_(data);
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [huge[:<MiB>] [stride:<Bytes>]] [vma-stress[:<Units>]]\n"
+            "       [uffd[:<Units>] [uffd-batch:<Pages>] [uffd-from:<Path>]]\n");
+    fprintf(out_stream, "  Without arguments: the interactive split/merge demonstration.\n"
+            "  'huge': maps MiB (default 256) with MAP_HUGETLB, MADV_HUGEPAGE, no advice\n"
+            "          and MADV_NOHUGEPAGE; touches them every 'stride' bytes\n"
+            "          (default 4096) and shows faults, AnonHugePages and access times.\n"
+            "  'vma-stress': makes every other unit (default 8192 units) read-only,\n"
+            "          one by one, timing mprotect(), mmap(), page faults as VMAs grow;\n"
+            "          then maps them again and checks for merging, then munmap()s;\n"
+            "          with want_offset_adjust = 1, then 0.\n"
+            "  'uffd': the test area (default 1024 units) is touched page by page,\n"
+            "          zero-filled by the kernel, then filled through userfaultfd\n"
+            "          by a handler thread: generated data, or read from 'uffd-from:'.\n");
+}
+
+
 int
-main (void)
+main (int argc, char* argv[])
 {
     mem_range  mr_test_area;  /* our playground */
     mem_range  mr_subarea1;  /* part of 'mr_test_area' */
     mem_range  mr_subarea2;  /* other part of 'mr_test_area' */
 
+    int  arg_pos;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        if (handle_arg_(argv[arg_pos]) != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+
+    if (huge_mib > 0) {
+        printf("Pid = %ld\n", (long) getpid());
+        run_hugepage_experiments((size_t) huge_mib * 1024 * 1024, huge_stride);
+        return 0;
+    }
+
     mapped_fd = open("/dev/zero", O_RDWR);
 
     if (mapped_fd < 0) {
@@ -157,10 +480,17 @@ main (void)
 
     printf("Pid = %ld\n", (long) getpid());
 
+    if (stress_units > 0) {
+        run_vma_stress_once_(stress_units);
+        want_offset_adjust = 0;
+        run_vma_stress_once_(stress_units);
+        return 0;
+    }
+
     mr_test_area.m_unit_offset = 0;  /* zero by definition for the main area */
     mr_test_area.m_fd_offset = 0;  /* could be a different offset if we want */
 
-    mr_test_area.m_len = 5 * Mem_Map_Unit;
+    mr_test_area.m_len = ((uffd_units > 0) ? uffd_units : 5) * Mem_Map_Unit;
 
     mr_test_area.m_base_addr = mmap(0, mr_test_area.m_len,
                                     PROT_READ | PROT_WRITE,
@@ -174,6 +504,20 @@ main (void)
     printf("\nOur test area = ");
     show_range_(&mr_test_area, stdout);
 
+    if (uffd_units > 0) {
+        int  backing_fd = -1;
+
+        if (uffd_backing_path != NULL) {
+            backing_fd = open(uffd_backing_path, O_RDONLY);
+            if (backing_fd < 0) {
+                perror(uffd_backing_path);
+                exit(13);
+            }
+        }
+        return run_userfault_bench(mr_test_area.m_base_addr, mr_test_area.m_len,
+                                   backing_fd, uffd_batch);
+    }
+
     fill_subrange_(&mr_subarea1, &mr_test_area, 1, 2);
     fill_subrange_(&mr_subarea2, &mr_test_area, 2, 2);
 
@@ -0,0 +1,489 @@
+/*
+ * demo-code/za-printf-bench.c
+ *
+ * Cost per formatted record: stdio unbuffered, line buffered and fully
+ * buffered (setvbuf() sizes from 4 KiB to 1 MiB), then writev() of
+ * snprintf()-formatted records and a hand-rolled formatter with write()
+ * as baselines --- to /dev/null, a regular file, a pipe and (optionally)
+ * the terminal.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for IOV_MAX with older glibc */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define RECORD_MAX  128
+
+/* records per writev() call; IOV_MAX is at least 16 (POSIX), 1024 on Linux */
+#define WRITEV_BATCH  64
+
+/* the hand-rolled formatter writes when this much is buffered */
+#define HAND_BUF_SIZE  (64 * 1024)
+
+static unsigned long  n_records = 1000000;
+
+static const char *file_path = "za-printf-bench.out";
+
+static int  want_tty = 0;
+
+typedef enum {
+    TARGET_NULL,
+    TARGET_FILE,
+    TARGET_PIPE,
+    TARGET_TTY,
+    TARGET_N_KINDS
+} target_kind;
+
+static const char *const Target_Names[TARGET_N_KINDS] = {
+    "/dev/null", "file", "pipe", "tty"
+};
+
+typedef enum {
+    MODE_UNBUFFERED,
+    MODE_LINE,
+    MODE_FULL_4K,
+    MODE_FULL_16K,
+    MODE_FULL_64K,
+    MODE_FULL_256K,
+    MODE_FULL_1M,
+    MODE_WRITEV,
+    MODE_HAND,
+    MODE_N_KINDS
+} write_mode;
+
+static const char *const Mode_Names[MODE_N_KINDS] = {
+    "stdio unbuffered", "stdio line", "stdio full 4K", "stdio full 16K",
+    "stdio full 64K", "stdio full 256K", "stdio full 1M",
+    "snprintf+writev", "hand-rolled+write"
+};
+
+static const size_t  Full_Sizes[] = {
+    4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024
+};
+
+
+static unsigned long
+parse_count_ (const char *data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse count '%s'\n",
+                data);
+        exit(11);
+    }
+
+    /* Optional suffix: M = million */
+    if ('m' == *end || 'M' == *end) {
+        value *= 1000000;
+        ++end;
+    }
+
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after count %lu\n",
+                end, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing count '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+    if (0 == value) {
+        fprintf(stderr, "The count must be above 0.\n");
+        exit(14);
+    }
+
+    return value;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    if (0 == strncmp("records:", arg, 8)) {
+        n_records = parse_count_(arg + 8);
+    }
+    else if (0 == strncmp("file:", arg, 5)) {
+        file_path = arg + 5;
+    }
+    else if (0 == strcmp("tty", arg)) {
+        want_tty = 1;
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [records:<N>] [file:<Path>] [tty]\n");
+    fprintf(out_stream, "  Writes N records (default 1000000; M suffix = million) in each mode\n"
+            "  to /dev/null, to 'file' (default ./za-printf-bench.out, removed at the end),\n"
+            "  to a pipe drained by a child process and, with 'tty', to /dev/tty.\n"
+            "  Shows ns per record.\n");
+}
+
+
+/*
+ * The record: a typical log line, with a few integers that change.
+ */
+#define RECORD_FORMAT  "%lu INFO worker-%02u request %lu took %u us status=%d\n"
+
+#define RECORD_ARGS(ix)  1760000000000UL + (ix), (unsigned) ((ix) % 16), \
+                         (ix) * 7, (unsigned) ((ix) % 1000), ((ix) % 97) ? 200 : 500
+
+static char *
+put_ulong_ (char *p, unsigned long value, int min_digits)
+{
+    char  digits[24];
+
+    int  n = 0;
+
+    do {
+        digits[n++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n < min_digits) {
+        digits[n++] = '0';
+    }
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+
+    return p;
+}
+
+static char *
+put_str_ (char *p, const char *s, size_t len)
+{
+    memcpy(p, s, len);
+
+    return p + len;
+}
+
+/*
+ * Same output as RECORD_FORMAT with RECORD_ARGS(ix).
+ */
+static char *
+format_by_hand_ (char *p, unsigned long ix)
+{
+    p = put_ulong_(p, 1760000000000UL + ix, 1);
+    p = put_str_(p, " INFO worker-", 13);
+    p = put_ulong_(p, ix % 16, 2);
+    p = put_str_(p, " request ", 9);
+    p = put_ulong_(p, ix * 7, 1);
+    p = put_str_(p, " took ", 6);
+    p = put_ulong_(p, ix % 1000, 1);
+    p = put_str_(p, " us status=", 11);
+    p = put_ulong_(p, (ix % 97) ? 200 : 500, 1);
+    *p++ = '\n';
+
+    return p;
+}
+
+static int
+write_all_ (int fd, const char *buf, size_t len)
+{
+    ssize_t  num_written;
+
+    while (len > 0) {
+        num_written = write(fd, buf, len);
+        if (num_written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return -1;
+        }
+        buf += num_written;
+        len -= (size_t) num_written;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns the fd, or -1 if the target is not available;
+ * for a pipe, '*child_pid' is the reader.
+ */
+static int
+open_target_ (target_kind target, pid_t *child_pid)
+{
+    char  buf[64 * 1024];
+
+    ssize_t  num_read;
+
+    int  pipe_fds[2];
+
+    *child_pid = -1;
+
+    switch (target) {
+    case TARGET_NULL:
+        return open("/dev/null", O_WRONLY | O_CLOEXEC);
+    case TARGET_FILE:
+        return open(file_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    case TARGET_TTY:
+        return open("/dev/tty", O_WRONLY | O_CLOEXEC);
+    case TARGET_PIPE:
+        if (pipe(pipe_fds) < 0) {
+            return -1;
+        }
+        *child_pid = fork();
+        if (*child_pid < 0) {
+            return -1;
+        }
+        if (0 == *child_pid) {
+            close(pipe_fds[1]);
+            do {
+                num_read = read(pipe_fds[0], buf, sizeof buf);
+            } while (num_read > 0 || (num_read < 0 && EINTR == errno));
+            _exit(0);
+        }
+        close(pipe_fds[0]);
+        return pipe_fds[1];
+    default:
+        return -1;
+    }
+}
+
+static int
+run_stdio_ (int fd, write_mode mode)
+{
+    FILE *out = fdopen(fd, "w");
+
+    unsigned long  ix;
+
+    int  res;
+
+    if (NULL == out) {
+        return -1;
+    }
+
+    /* setvbuf() must come before any output on the stream. */
+    if (MODE_UNBUFFERED == mode) {
+        res = setvbuf(out, NULL, _IONBF, 0);
+    } else if (MODE_LINE == mode) {
+        res = setvbuf(out, NULL, _IOLBF, BUFSIZ);
+    } else {
+        res = setvbuf(out, NULL, _IOFBF, Full_Sizes[mode - MODE_FULL_4K]);
+    }
+    if (res != 0) {
+        fclose(out);
+        return -1;
+    }
+
+    for (ix = 0; ix < n_records; ++ix) {
+        fprintf(out, RECORD_FORMAT, RECORD_ARGS(ix));
+    }
+
+    return fclose(out);  /* closes 'fd' too */
+}
+
+static int
+run_writev_ (int fd)
+{
+    static char  slots[WRITEV_BATCH][RECORD_MAX];
+
+    struct iovec  iov[WRITEV_BATCH];
+
+    unsigned long  ix;
+
+    int  n_iov = 0;
+    int  len;
+
+    for (ix = 0; ix < n_records; ++ix) {
+        len = snprintf(slots[n_iov], RECORD_MAX, RECORD_FORMAT, RECORD_ARGS(ix));
+        iov[n_iov].iov_base = slots[n_iov];
+        iov[n_iov].iov_len = (size_t) len;
+        if (++n_iov == WRITEV_BATCH || ix + 1 == n_records) {
+            /* Short writes would need a resume; pipes and files do not
+             * make them here, and this is a benchmark. */
+            if (writev(fd, iov, n_iov) < 0) {
+                return -1;
+            }
+            n_iov = 0;
+        }
+    }
+
+    return close(fd);
+}
+
+static int
+run_hand_ (int fd)
+{
+    static char  buf[HAND_BUF_SIZE + RECORD_MAX];
+
+    char *p = buf;
+
+    unsigned long  ix;
+
+    for (ix = 0; ix < n_records; ++ix) {
+        p = format_by_hand_(p, ix);
+        if (p - buf >= HAND_BUF_SIZE) {
+            if (write_all_(fd, buf, (size_t) (p - buf)) != 0) {
+                return -1;
+            }
+            p = buf;
+        }
+    }
+    if (p > buf && write_all_(fd, buf, (size_t) (p - buf)) != 0) {
+        return -1;
+    }
+
+    return close(fd);
+}
+
+/*
+ * Returns ns per record, or a negative value if the target
+ * is not available.
+ */
+static double
+run_one_ (target_kind target, write_mode mode)
+{
+    unsigned long long  t_begin;
+    unsigned long long  elapsed;
+
+    pid_t  child_pid;
+
+    int  fd;
+    int  res;
+
+    fd = open_target_(target, &child_pid);
+    if (fd < 0) {
+        return -1.0;
+    }
+
+    t_begin = ulat_now_ns();
+    if (MODE_WRITEV == mode) {
+        res = run_writev_(fd);
+    } else if (MODE_HAND == mode) {
+        res = run_hand_(fd);
+    } else {
+        res = run_stdio_(fd, mode);
+    }
+    if (child_pid > 0) {
+        waitpid(child_pid, NULL, 0);  /* the reader has seen everything */
+    }
+    elapsed = ulat_now_ns() - t_begin;
+
+    if (res != 0) {
+        fprintf(stderr, "%s to %s failed: errno %d = %s\n",
+                Mode_Names[mode], Target_Names[target], errno, strerror(errno));
+        return -1.0;
+    }
+
+    return (double) elapsed / (double) n_records;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    char  record[RECORD_MAX];
+    char  by_hand[RECORD_MAX];
+    char  line[256];
+
+    double  ns;
+
+    int  len;
+    int  n_targets;
+    int  target;
+    int  mode;
+    int  arg_pos;
+    int  res;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg_(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+    n_targets = want_tty ? TARGET_N_KINDS : TARGET_TTY;
+
+    /* The baselines must write exactly what printf() writes. */
+    snprintf(record, sizeof record, RECORD_FORMAT, RECORD_ARGS(12345UL));
+    *format_by_hand_(by_hand, 12345UL) = '\0';
+    if (strcmp(record, by_hand) != 0) {
+        fprintf(stderr, "Hand-rolled formatter mismatch:\n%s%s", record, by_hand);
+        return 3;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("%lu records like: %s", n_records, record);
+    printf("ns per record (including the close/flush at the end):\n");
+    printf("%-20s", "mode");
+    for (target = 0; target < n_targets; ++target) {
+        printf(" %10s", Target_Names[target]);
+    }
+    printf("\n");
+    fflush(stdout);  /* before any tty output, and before fork() */
+
+    for (mode = 0; mode < MODE_N_KINDS; ++mode) {
+        len = snprintf(line, sizeof line, "%-20s", Mode_Names[mode]);
+
+        for (target = 0; target < n_targets; ++target) {
+            ns = run_one_((target_kind) target, (write_mode) mode);
+            if (ns < 0) {
+                len += snprintf(line + len, sizeof line - (size_t) len, " %10s", "-");
+            } else {
+                len += snprintf(line + len, sizeof line - (size_t) len, " %10.1f", ns);
+            }
+        }
+        /* After the tty runs, so the row is not lost among the records. */
+        printf("%s\n", line);
+        fflush(stdout);
+    }
+
+    unlink(file_path);
+
+    return 0;
+}
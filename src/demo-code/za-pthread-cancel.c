@@ -20,6 +20,7 @@
 #include <sys/select.h>
 #include <unistd.h>
 
+#include "util-async-log.h"
 #include "util-timeval.h"
 
 /*
@@ -49,6 +50,12 @@ static char  cancelstate_chr = 'n';  /* option 'None' = Don't set cancellation s
 static char  canceltype_chr  = 'n';  /* option 'None' = Don't set cancellation type */
 static char  cancel_request_chr = '1';
 
+/*
+ * printf() is a cancellation point, queueing a record is not:
+ * with the async log the sleeper can only be canceled in select().
+ */
+static int  want_async_log = 0;
+
 static void
 apply_thread_cancellation_settings_ (void)
 {
@@ -137,6 +144,7 @@ sleeper_thread_func (void *arg)
     fprintf(stdout, "\nCycle time: ");
     show_timeval(&cycle_tval, stdout);
     fprintf(stdout, ".\n");
+    ualog_flush();  /* the messages in the loop may go to the async log */
 
     while (num_cycles < num_max_cycles) {
         tval = cycle_tval;
@@ -146,7 +154,7 @@ sleeper_thread_func (void *arg)
         ++num_cycles;
 
         if (sel_res == 0) {  /* timeout */
-            printf("    [cycle %lu / %lu: OK]\n", num_cycles, num_max_cycles);
+            UALOG_PRINTF("    [cycle %lu / %lu: OK]\n", num_cycles, num_max_cycles);
         } else {
             assert(sel_res == -1);
 
@@ -160,9 +168,9 @@ sleeper_thread_func (void *arg)
 
             if (EINTR == sel_err) {
                 ++num_intr;
-                fprintf(stderr, "[%lu cycles: %lu intr, %lu fail]"
-                        " select() interrupted: errno %d = %s\n",
-                        num_cycles, num_intr, num_fail, sel_err, err_buf);
+                UALOG_EPRINTF("[%lu cycles: %lu intr, %lu fail]"
+                              " select() interrupted: errno %d = %s\n",
+                              num_cycles, num_intr, num_fail, sel_err, err_buf);
             } else if (EINVAL == sel_err) {
                 /*
                  * Given the way we call select() here (no file descriptors),
@@ -178,13 +186,15 @@ sleeper_thread_func (void *arg)
                 exit(90);
             } else {
                 ++num_fail;
-                fprintf(stderr, "[%lu cycles: %lu intr, %lu fail]"
-                        " Unexpected errno %d from select(): %s\n",
-                        num_cycles, num_intr, num_fail, sel_err, err_buf);
+                UALOG_EPRINTF("[%lu cycles: %lu intr, %lu fail]"
+                              " Unexpected errno %d from select(): %s\n",
+                              num_cycles, num_intr, num_fail, sel_err, err_buf);
             }
         }
     }
 
+    ualog_flush();
+
     printf("\nSleeping loop finished after"
            "\n  %lu cycles,"
            "\n  %lu times select() was unexpectedly interrupted,"
@@ -273,6 +283,9 @@ handle_arg_ (const char *arg)
 
         cancel_request_chr = data[0];
     }
+    else if (0 == strcmp("asynclog", arg)) {
+        want_async_log = 1;
+    }
     else {
         return -1;
     }
@@ -284,7 +297,11 @@ handle_arg_ (const char *arg)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [state:d|e|n] [type:a|d|n] [req:0|1]\n");
+    fprintf(out_stream, "Usage: [state:d|e|n] [type:a|d|n] [req:0|1] [asynclog]\n");
+    fprintf(out_stream, "  'asynclog': the sleeper queues its messages to a background writer thread\n"
+            "  (see util-async-log.h) instead of calling printf(), a cancellation point.\n"
+            "  With 'type:a' too, the sleeper is never cancelled while queueing a message:\n"
+            "  the queueing disables cancellation until done.\n");
     show_all_thread_cancellation_options_(out_stream);
 }
 
@@ -313,6 +330,15 @@ main (int argc, char* argv[])
         }
     }
 
+    if (want_async_log) {
+        res = ualog_start();
+        if (res != 0) {
+            fprintf(stderr, "Could not start the async log: errno %d = %s\n",
+                    res, strerror(res));
+            exit(13);
+        }
+    }
+
     tcreate_res = pthread_create(
                     &thread_id,
                     NULL,
@@ -342,6 +368,7 @@ main (int argc, char* argv[])
     printf("Waiting for thread termination (join)...\n");
 
     tjoin_res = pthread_join(thread_id, &thr_retval);
+    ualog_stop(stdout);
 
     if (tjoin_res == 0) {
         if (PTHREAD_CANCELED == thr_retval) {
@@ -4,6 +4,11 @@
  * Create one or many threads (one per CLI arg) and try to join each of them,
  * including the detached threads --- which invokes undefined behavior!
  *
+ * Benchmark mode ('bench:<N>'): create (and join) N short-lived threads,
+ * measuring the thread creation cost for various thread attributes.
+ * Or ('poolbench:<N>'): run N small tasks with a thread per task,
+ * then with a persistent pool of worker threads.
+ *
  * SPDX-License-Identifier: GPL-2.0-or-later
  *
  * Copyright (c) 2014--2025 Alexandru Nedel
@@ -14,15 +19,21 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>  /* for 'PTHREAD_STACK_MIN' */
 #include <pthread.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/select.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "util-async-log.h"
+#include "util-latency.h"
 #include "util-timeval.h"
+#include "util-work-pool.h"
 
 /*
  * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
@@ -277,6 +288,7 @@ sleeper_thread_func (void *arg)
     fprintf(stdout, "%s Cycle time: ", message_preamble);
     show_timeval(&cycle_tval, stdout);
     fprintf(stdout, ".\n");
+    ualog_flush();  /* the messages in the loop may go to the async log */
 
     while (stop_sig == 0) {
         tval = cycle_tval;
@@ -304,16 +316,16 @@ sleeper_thread_func (void *arg)
 
             if (EINTR == sel_err) {
                 if (stop_sig != 0) {
-                    fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                            " select() interrupted (probably signal %d): errno %d = %s\n",
-                            message_preamble, num_cycles, num_intr, num_fail,
-                            stop_sig, sel_err, err_buf);
+                    UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                                  " select() interrupted (probably signal %d): errno %d = %s\n",
+                                  message_preamble, num_cycles, num_intr, num_fail,
+                                  (int) stop_sig, sel_err, err_buf);
                 } else {
                     ++num_intr;
-                    fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                            " select() unexpectedly interrupted: errno %d = %s\n",
-                            message_preamble, num_cycles, num_intr, num_fail,
-                            sel_err, err_buf);
+                    UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                                  " select() unexpectedly interrupted: errno %d = %s\n",
+                                  message_preamble, num_cycles, num_intr, num_fail,
+                                  sel_err, err_buf);
                 }
             } else if (EINVAL == sel_err) {
                 /*
@@ -330,13 +342,15 @@ sleeper_thread_func (void *arg)
                 exit(90);
             } else {
                 ++num_fail;
-                fprintf(stderr, "%s [%lu cycles: %lu intr, %lu fail]"
-                        " Unexpected errno %d from select(): %s\n",
-                        message_preamble, num_cycles, num_intr, num_fail, sel_err, err_buf);
+                UALOG_EPRINTF("%s [%lu cycles: %lu intr, %lu fail]"
+                              " Unexpected errno %d from select(): %s\n",
+                              message_preamble, num_cycles, num_intr, num_fail, sel_err, err_buf);
             }
         }
     }
 
+    ualog_flush();
+
     printf("  %s: Sleeping loop finished after %lu cycles, %lu intr, %lu fail.\n",
            message_preamble, num_cycles, num_intr, num_fail);
     fflush(stdout);
@@ -431,6 +445,548 @@ handle_arg_start_thread_ (const char *arg)
 }
 
 
+/*
+ * Benchmark mode.
+ */
+
+#define DEFAULT_GUARD  ((size_t) -1)  /* do not call pthread_attr_setguardsize() */
+
+typedef struct {
+    const char *bc_name;  /* for the summary table */
+
+    size_t  bc_stack_size;  /* zero: default */
+    size_t  bc_guard_size;  /* DEFAULT_GUARD: default */
+    int     bc_detached;
+} bench_config;
+
+/*
+ * Runs with the configs below show what matters: glibc keeps the stacks
+ * of finished threads in a cache (about 40 MBytes by default), so
+ * only stacks that do not fit there cost an mmap()/munmap() per thread;
+ * a guard page change means an mprotect() for every stack reuse.
+ */
+static const bench_config  Sweep_Configs[] = {
+    { "defaults",             0,                 DEFAULT_GUARD, 0 },
+    { "stack min",            PTHREAD_STACK_MIN, DEFAULT_GUARD, 0 },
+    { "stack 64K",            64 * 1024,         DEFAULT_GUARD, 0 },
+    { "stack 256K",           256 * 1024,        DEFAULT_GUARD, 0 },
+    { "stack 1M",             1024 * 1024,       DEFAULT_GUARD, 0 },
+    { "stack 8M",             8 * 1024 * 1024,   DEFAULT_GUARD, 0 },
+    { "stack 64M",            64 * 1024 * 1024,  DEFAULT_GUARD, 0 },
+    { "guard 0",              0,                 0,             0 },
+    { "guard 1M",             0,                 1024 * 1024,   0 },
+    { "detached",             0,                 DEFAULT_GUARD, 1 },
+    { "detached, stack 64K",  64 * 1024,         DEFAULT_GUARD, 1 }
+};
+static const int  N_Sweep_Configs =
+    sizeof Sweep_Configs / sizeof Sweep_Configs[0];
+
+typedef struct {
+    unsigned long long  bt_created_ns;    /* written before pthread_create() */
+    unsigned long long  bt_first_run_ns;  /* written by the new thread */
+} bench_thread_arg;
+
+typedef struct {
+    int  br_ok;
+
+    double  br_creates_per_s;
+
+    unsigned long long  br_create_p50_ns;
+    unsigned long long  br_create_p99_ns;
+    unsigned long long  br_first_run_p50_ns;
+    unsigned long long  br_first_run_p99_ns;
+
+    unsigned long  br_num_retries;
+} bench_result;
+
+static unsigned long  bench_iterations = 0;  /* zero: not in benchmark mode */
+static int            want_sweep = 0;
+
+static bench_config  cli_bench_config = { "", 0, DEFAULT_GUARD, 0 };
+
+static bench_thread_arg *bench_args;  /* 'bench_iterations' entries */
+static atomic_ulong       bench_num_done;
+
+
+static void *
+bench_thread_func (void *arg)
+{
+    bench_thread_arg *const barg = arg;
+
+    barg->bt_first_run_ns = ulat_now_ns();
+
+    /* Release: the detached case has no join to make the store visible. */
+    atomic_fetch_add_explicit(&bench_num_done, 1, memory_order_release);
+
+    return barg;
+}
+
+static void
+sleep_briefly_ (void)
+{
+    struct timespec  tspec = { 0, 100000 };  /* 100 usec */
+
+    nanosleep(&tspec, NULL);
+}
+
+static int
+init_bench_attr_ (pthread_attr_t *attr, const bench_config *bc)
+{
+    errno_t  res;
+
+    res = pthread_attr_init(attr);
+    if (res != 0) {
+        fprintf(stderr, "pthread_attr_init() failed, returning the errno value %d.\n", res);
+        exit(36);
+    }
+
+    if (bc->bc_stack_size > 0) {
+        res = pthread_attr_setstacksize(attr, bc->bc_stack_size);
+        if (res != 0) {
+            printf("pthread_attr_setstacksize(%lu) failed, returning the errno value %d = %s\n",
+                   (unsigned long) bc->bc_stack_size, res, strerror(res));
+            return -1;
+        }
+    }
+    if (bc->bc_guard_size != DEFAULT_GUARD) {
+        res = pthread_attr_setguardsize(attr, bc->bc_guard_size);
+        if (res != 0) {
+            printf("pthread_attr_setguardsize(%lu) failed, returning the errno value %d = %s\n",
+                   (unsigned long) bc->bc_guard_size, res, strerror(res));
+            return -2;
+        }
+    }
+    if (bc->bc_detached) {
+        pthread_attr_setdetachstate(attr, PTHREAD_CREATE_DETACHED);
+    }
+
+    return 0;
+}
+
+static void
+run_bench_ (const bench_config *bc, bench_result *br)
+{
+    pthread_attr_t  attr;
+    pthread_t       tid;
+
+    ulat_hist  create_hist;
+    ulat_hist  first_run_hist;
+    ulat_hist  join_hist;
+
+    unsigned long long  t_begin;
+    unsigned long long  t_before;
+    unsigned long long  t_after;
+    double  elapsed_s;
+
+    errno_t  tcreate_res;
+    errno_t  tjoin_res;
+
+    unsigned long  ix;
+
+    memset(br, 0, sizeof *br);
+
+    printf("\n=== %s: %lu threads, %s, stack size %lu%s, guard size %lu%s\n",
+           bc->bc_name, bench_iterations,
+           bc->bc_detached ? "detached" : "joinable",
+           (unsigned long) bc->bc_stack_size, (bc->bc_stack_size > 0) ? "" : " (default)",
+           (bc->bc_guard_size != DEFAULT_GUARD) ? (unsigned long) bc->bc_guard_size : 0UL,
+           (bc->bc_guard_size != DEFAULT_GUARD) ? "" : " (default)");
+
+    if (init_bench_attr_(&attr, bc) != 0) {
+        pthread_attr_destroy(&attr);
+        return;
+    }
+
+    ulat_hist_reset(&create_hist);
+    ulat_hist_reset(&first_run_hist);
+    ulat_hist_reset(&join_hist);
+
+    atomic_store(&bench_num_done, 0);
+
+    t_begin = ulat_now_ns();
+
+    for (ix = 0; ix < bench_iterations; ++ix) {
+        bench_args[ix].bt_first_run_ns = 0;
+
+        do {
+            t_before = ulat_now_ns();
+            bench_args[ix].bt_created_ns = t_before;
+            tcreate_res = pthread_create(&tid, &attr, &bench_thread_func, &bench_args[ix]);
+            t_after = ulat_now_ns();
+
+            if (EAGAIN == tcreate_res) {
+                /* Too many detached threads still alive; let some finish. */
+                ++br->br_num_retries;
+                sleep_briefly_();
+            }
+        } while (EAGAIN == tcreate_res);
+
+        if (tcreate_res != 0) {
+            printf("[%lu] pthread_create() failed, returning the errno value %d = %s\n",
+                   ix, tcreate_res, strerror(tcreate_res));
+            pthread_attr_destroy(&attr);
+            exit(37);  /* threads already started could not be joined safely */
+        }
+
+        ulat_hist_add(&create_hist, t_after - t_before);
+
+        if (!bc->bc_detached) {
+            t_before = ulat_now_ns();
+            tjoin_res = pthread_join(tid, NULL);
+            t_after = ulat_now_ns();
+
+            if (tjoin_res != 0) {
+                printf("[%lu] pthread_join() failed, returning the errno value %d = %s\n",
+                       ix, tjoin_res, strerror(tjoin_res));
+                exit(38);
+            }
+
+            ulat_hist_add(&join_hist, t_after - t_before);
+        }
+    }
+
+    /* Detached threads: wait until all of them have run. */
+    while (atomic_load_explicit(&bench_num_done, memory_order_acquire) < bench_iterations) {
+        sleep_briefly_();
+    }
+
+    elapsed_s = (double) (ulat_now_ns() - t_begin) / 1e9;
+
+    pthread_attr_destroy(&attr);
+
+    for (ix = 0; ix < bench_iterations; ++ix) {
+        ulat_hist_add(&first_run_hist,
+                      bench_args[ix].bt_first_run_ns - bench_args[ix].bt_created_ns);
+    }
+
+    printf("Created %lu threads in %.3f s: %.0f creates/s%s",
+           bench_iterations, elapsed_s, (double) bench_iterations / elapsed_s,
+           bc->bc_detached ? "" : " (each one joined before the next create)");
+    if (br->br_num_retries > 0) {
+        printf("; %lu retries after EAGAIN", br->br_num_retries);
+    }
+    printf(".\n");
+
+    ulat_show_hist(&create_hist, "  pthread_create() call:", stdout);
+    ulat_show_hist(&first_run_hist, "  create-to-first-run:", stdout);
+    if (!bc->bc_detached) {
+        ulat_show_hist(&join_hist, "  pthread_join() call:", stdout);
+    }
+
+    br->br_ok = 1;
+    br->br_creates_per_s = (double) bench_iterations / elapsed_s;
+    br->br_create_p50_ns = ulat_hist_percentile(&create_hist, 50.0);
+    br->br_create_p99_ns = ulat_hist_percentile(&create_hist, 99.0);
+    br->br_first_run_p50_ns = ulat_hist_percentile(&first_run_hist, 50.0);
+    br->br_first_run_p99_ns = ulat_hist_percentile(&first_run_hist, 99.0);
+}
+
+static int
+run_benchmarks_ (void)
+{
+    const bench_config *configs;
+    bench_result       *results;
+
+    int  num_configs;
+    int  ix;
+
+    if (want_sweep) {
+        configs = Sweep_Configs;
+        num_configs = N_Sweep_Configs;
+    } else {
+        configs = &cli_bench_config;
+        num_configs = 1;
+    }
+
+    bench_args = calloc(bench_iterations, sizeof bench_args[0]);
+    results = calloc((size_t) num_configs, sizeof results[0]);
+    if (NULL == bench_args || NULL == results) {
+        perror("calloc(bench_args, results)");
+        return 3;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+
+    for (ix = 0; ix < num_configs; ++ix) {
+        run_bench_(&configs[ix], &results[ix]);
+    }
+
+    printf("\n=== Summary (%lu threads per run; latencies in usec):\n", bench_iterations);
+    printf("%-22s %11s %11s %11s %11s %11s\n", "attributes", "creates/s",
+           "create p50", "create p99", "1st run p50", "1st run p99");
+    for (ix = 0; ix < num_configs; ++ix) {
+        if (!results[ix].br_ok) {
+            printf("%-22s %11s\n", configs[ix].bc_name, "failed");
+            continue;
+        }
+        printf("%-22s %11.0f %11.3f %11.3f %11.3f %11.3f\n", configs[ix].bc_name,
+               results[ix].br_creates_per_s,
+               results[ix].br_create_p50_ns / 1e3, results[ix].br_create_p99_ns / 1e3,
+               results[ix].br_first_run_p50_ns / 1e3, results[ix].br_first_run_p99_ns / 1e3);
+    }
+
+    free(results);
+    free(bench_args);
+
+    return 0;
+}
+
+/*
+ * Pool benchmark: a thread per task versus a persistent work-stealing pool,
+ * with the same number of threads running at the same time.
+ */
+
+static unsigned long  poolbench_tasks = 0;  /* zero: not in this mode */
+static unsigned long  poolbench_work = 1000;  /* loop iterations per task */
+static int            poolbench_workers = 4;
+
+static void
+busy_work_ (unsigned long iterations)
+{
+    volatile unsigned long  sink = 0;
+
+    unsigned long  ix;
+
+    for (ix = 0; ix < iterations; ++ix) {
+        sink += ix;
+    }
+}
+
+static void
+pool_task_func_ (void *arg)
+{
+    bench_thread_arg *const barg = arg;
+
+    barg->bt_first_run_ns = ulat_now_ns();
+    busy_work_(poolbench_work);
+}
+
+static void *
+spawned_task_func_ (void *arg)
+{
+    pool_task_func_(arg);
+
+    return arg;
+}
+
+static double
+show_poolbench_result_ (const char *name, unsigned long long elapsed_ns)
+{
+    ulat_hist  start_hist;
+
+    const double  tasks_per_s = (double) poolbench_tasks * 1e9 / (double) elapsed_ns;
+
+    unsigned long  ix;
+
+    ulat_hist_reset(&start_hist);
+    for (ix = 0; ix < poolbench_tasks; ++ix) {
+        ulat_hist_add(&start_hist,
+                      bench_args[ix].bt_first_run_ns - bench_args[ix].bt_created_ns);
+    }
+
+    printf("%s: %lu tasks in %.3f ms: %.0f tasks/s\n",
+           name, poolbench_tasks, (double) elapsed_ns / 1e6, tasks_per_s);
+    ulat_show_hist(&start_hist, "  submit-to-start:", stdout);
+
+    return tasks_per_s;
+}
+
+static int
+run_poolbench_ (void)
+{
+    pthread_t *tids;
+    uwp_pool  *pool;
+
+    unsigned long long  t_begin;
+    unsigned long long  t_created;
+    unsigned long long  spawn_ns;
+    unsigned long long  pool_ns;
+
+    double  spawn_rate;
+    double  pool_rate;
+
+    errno_t  res;
+
+    unsigned long  ix;
+    unsigned long  batch_end;
+    unsigned long  jx;
+
+    bench_args = calloc(poolbench_tasks, sizeof bench_args[0]);
+    tids = calloc((size_t) poolbench_workers, sizeof tids[0]);
+    if (NULL == bench_args || NULL == tids) {
+        perror("calloc(bench_args, tids)");
+        return 3;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("%lu tasks of %lu loop iterations, at most %d at a time.\n\n",
+           poolbench_tasks, poolbench_work, poolbench_workers);
+
+    /* A thread per task, in batches of 'poolbench_workers' threads: */
+    t_begin = ulat_now_ns();
+    for (ix = 0; ix < poolbench_tasks; ix = batch_end) {
+        batch_end = ix + (unsigned long) poolbench_workers;
+        if (batch_end > poolbench_tasks) {
+            batch_end = poolbench_tasks;
+        }
+
+        for (jx = ix; jx < batch_end; ++jx) {
+            bench_args[jx].bt_created_ns = ulat_now_ns();
+            res = pthread_create(&tids[jx - ix], NULL, &spawned_task_func_, &bench_args[jx]);
+            if (res != 0) {
+                printf("[%lu] pthread_create() failed, returning the errno value %d = %s\n",
+                       jx, res, strerror(res));
+                exit(41);
+            }
+        }
+        for (jx = ix; jx < batch_end; ++jx) {
+            pthread_join(tids[jx - ix], NULL);
+        }
+    }
+    spawn_ns = ulat_now_ns() - t_begin;
+
+    spawn_rate = show_poolbench_result_("thread per task", spawn_ns);
+
+    /* Persistent pool; its startup is measured separately: */
+    t_begin = ulat_now_ns();
+    pool = uwp_create(poolbench_workers);
+    if (NULL == pool) {
+        perror("uwp_create()");
+        exit(42);
+    }
+    t_created = ulat_now_ns();
+
+    for (ix = 0; ix < poolbench_tasks; ++ix) {
+        bench_args[ix].bt_created_ns = ulat_now_ns();
+        res = uwp_submit(pool, &pool_task_func_, &bench_args[ix]);
+        if (res != 0) {
+            printf("[%lu] uwp_submit() failed, returning the errno value %d = %s\n",
+                   ix, res, strerror(res));
+            exit(43);
+        }
+    }
+    uwp_wait_idle(pool);
+    pool_ns = ulat_now_ns() - t_created;
+
+    printf("\n(starting the pool took %.3f ms)\n", (double) (t_created - t_begin) / 1e6);
+    pool_rate = show_poolbench_result_("pool", pool_ns);
+    printf("  (all the tasks are queued at once, so submit-to-start includes the wait"
+           " behind earlier tasks)\n");
+    uwp_show_stats(pool, "  pool", stdout);
+
+    uwp_destroy(pool);
+
+    printf("\nPool / thread per task: %.2f times the throughput.\n",
+           pool_rate / spawn_rate);
+
+    free(tids);
+    free(bench_args);
+
+    return 0;
+}
+
+
+static unsigned long
+parse_count (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(31);
+    }
+
+    /* Optional suffix for sizes: K = KiB, M = MiB */
+    if ('k' == *end || 'K' == *end) {
+        value *= 1024;
+        ++end;
+    } else if ('m' == *end || 'M' == *end) {
+        value *= 1024 * 1024;
+        ++end;
+    }
+
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(32);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(33);
+    }
+
+    return value;
+}
+
+/*
+ * Returns zero if the argument is one of the benchmark options.
+ */
+static int
+handle_bench_arg_ (const char *arg)
+{
+    const char *data;
+
+    if (0 == strncmp("bench:", arg, 6)) {
+        data = arg + 6;
+        bench_iterations = parse_count(data, "number of threads");
+        if (0 == bench_iterations) {
+            fprintf(stderr, "The number of threads must be positive.\n");
+            exit(34);
+        }
+    }
+    else if (0 == strncmp("stack:", arg, 6)) {
+        data = arg + 6;
+        cli_bench_config.bc_stack_size = parse_count(data, "stack size");
+    }
+    else if (0 == strncmp("guard:", arg, 6)) {
+        data = arg + 6;
+        cli_bench_config.bc_guard_size = parse_count(data, "guard size");
+    }
+    else if (0 == strcmp("detached", arg)) {
+        cli_bench_config.bc_detached = 1;
+    }
+    else if (0 == strcmp("sweep", arg)) {
+        want_sweep = 1;
+    }
+    else if (0 == strncmp("poolbench:", arg, 10)) {
+        data = arg + 10;
+        poolbench_tasks = parse_count(data, "number of tasks");
+        if (0 == poolbench_tasks) {
+            fprintf(stderr, "The number of tasks must be positive.\n");
+            exit(34);
+        }
+    }
+    else if (0 == strncmp("workers:", arg, 8)) {
+        data = arg + 8;
+        poolbench_workers = (int) parse_count(data, "number of workers");
+        if (poolbench_workers < 1 || poolbench_workers > UWP_WORKERS_MAX) {
+            fprintf(stderr, "The number of workers must be between 1 and %d.\n",
+                    UWP_WORKERS_MAX);
+            exit(35);
+        }
+    }
+    else if (0 == strncmp("work:", arg, 5)) {
+        data = arg + 5;
+        poolbench_work = parse_count(data, "loop iterations per task");
+    }
+    else {
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static double
 parse_cycle_time (const char *data)
 {
@@ -473,11 +1029,22 @@ parse_cycle_time (const char *data)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [cycle_time=<Seconds_with_decimals>]"
+    fprintf(out_stream, "Usage: [cycle_time=<Seconds_with_decimals>] [asynclog]"
             " <Threads:one_or_many(j...|d...)>\n");
 
     fprintf(out_stream, "  The thread name prefix 'j' stands for \"Joinable\".\n");
     fprintf(out_stream, "  The thread name prefix 'd' stands for \"Detached\".\n");
+    fprintf(out_stream, "  'asynclog': the sleepers queue their messages to a background writer thread\n"
+            "  (see util-async-log.h).\n");
+
+    fprintf(out_stream, "Or, benchmark mode: bench:<N> [stack:<Bytes>] [guard:<Bytes>]"
+            " [detached] [sweep]\n");
+    fprintf(out_stream, "  Creates (and joins, unless 'detached') N threads, one after another;\n"
+            "  sizes may have a K or M suffix.  'sweep' ignores the other attributes\n"
+            "  and runs a set of stack/guard/detached combinations.\n");
+    fprintf(out_stream, "Or, pool benchmark mode: poolbench:<N> [workers:<W>] [work:<Iterations>]\n");
+    fprintf(out_stream, "  Runs N tasks with a thread per task (W at a time),\n"
+            "  then with a pool of W worker threads.\n");
 }
 
 int
@@ -492,6 +1059,7 @@ main (int argc, char* argv[])
     int  arg_pos = 1;
     int  res;
     int  join_res;
+    int  want_async_log = 0;
     int  ix;
 
     const char *data;
@@ -504,6 +1072,41 @@ main (int argc, char* argv[])
         }
     }
 
+    if (arg_pos < argc) {
+        if (0 == strcmp("asynclog", argv[arg_pos])) {
+            want_async_log = 1;
+            ++arg_pos;
+        }
+    }
+
+    while (arg_pos < argc && 0 == handle_bench_arg_(argv[arg_pos])) {
+        ++arg_pos;
+    }
+
+    if (poolbench_tasks > 0) {
+        if (arg_pos < argc || bench_iterations > 0) {
+            fprintf(stderr, "Unexpected argument '%s' in pool benchmark mode.\n",
+                    (arg_pos < argc) ? argv[arg_pos] : "bench:...");
+            show_usage(stderr);
+            return 2;
+        }
+        return run_poolbench_();
+    }
+
+    if (want_sweep && 0 == bench_iterations) {
+        bench_iterations = 2000;
+    }
+    if (bench_iterations > 0) {
+        if (arg_pos < argc) {
+            fprintf(stderr, "Unexpected argument '%s' in benchmark mode.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+        cli_bench_config.bc_name = "command line";
+        return run_benchmarks_();
+    }
+
     memset(&act, 0, sizeof act);
 
     act.sa_handler = &soft_stop_handler;
@@ -521,6 +1124,16 @@ main (int argc, char* argv[])
     printf("(The threads will finish when this process receives SIGINT:\n"
            "    one way to cause SIGINT is to press Ctrl-C in terminal.)\n\n");
 
+    if (want_async_log) {
+        /* the writer thread blocks all signals: SIGINT still stops the sleepers */
+        res = ualog_start();
+        if (res != 0) {
+            fprintf(stderr, "Could not start the async log: errno %d = %s\n",
+                    res, strerror(res));
+            exit(13);
+        }
+    }
+
     /*
      * Start handling the thread arguments only _after_ setting up
      * the signal handling (soft stop, in this program)
@@ -576,6 +1189,8 @@ main (int argc, char* argv[])
         }
     }
 
+    ualog_stop(stdout);
+
     printf("Normal exit: %lu, canceled: %lu; %lu could not be joined.\n",
            num_normal_exit, num_canceled, num_join_fail);
 
@@ -4,6 +4,9 @@
  * Demonstration with POSIX Threads synchronizing with
  * Condition Variable and Semaphore
  *
+ * Benchmark mode ('bench:<N>'): non-interactive, measures wakeup latency
+ * and handoff rate for semaphores, condition variables and futexes.
+ *
  * SPDX-License-Identifier: GPL-2.0-or-later
  *
  * Copyright (c) 2014--2025 Alexandru Nedel
@@ -15,6 +18,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdio.h>
@@ -25,6 +29,7 @@
 
 #include "util-ex-threads.h"
 #include "util-mutexattr.h"
+#include "wakeup-bench.h"
 
 /*
  * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
@@ -674,10 +679,36 @@ command_loop_ (void)
 }
 
 
+/*
+ * Zero: the waiting threads show each step (lock, wakeup, unlock, ...).
+ * Positive: they only update their counters, and
+ * a reporter thread shows them every 'report_period' seconds.
+ */
+static double  report_period = 0.0;
+
+static ucnt_block *
+counters_for_ (uex_thread_info *tinfo)
+{
+    return (report_period > 0.0) ? &tinfo->counters : NULL;
+}
+
+/*
+ * A thread canceled inside pthread_cond_wait() (or in printf(), while
+ * holding the mutex) must not leave the demo mutex locked:
+ * the other waiting threads could never be woken and joined.
+ */
+static void
+unlock_demo_mutex_ (void *arg)
+{
+    (void) arg;
+    pthread_mutex_unlock(&demo_mutex);
+}
+
 static void *
 condvar_wait_thread_func (void *arg)
 {
     uex_thread_info *const tinfo = arg;
+    ucnt_block *const  counters = counters_for_(tinfo);
 
     unsigned long  num_wakeups = 0;
 
@@ -685,32 +716,59 @@ condvar_wait_thread_func (void *arg)
     errno_t  cond_res;
 
     while (1) {
+        ucnt_inc(counters, UCNT_CYCLES);
+
         mutex_res = pthread_mutex_lock(&demo_mutex);
-        if (mutex_res == 0) {
+        if (mutex_res != 0) {
+            /* Not locked: no cleanup handler, and no pthread_cond_wait(). */
+            ucnt_inc(counters, UCNT_FAIL);
+            if (NULL == counters) {
+                printf(" %s [%lu wakeups] pthread_mutex_lock() failed, returning the errno value %d.\n",
+                       tinfo->config_str, num_wakeups, mutex_res);
+            }
+            delay_(tinfo->config_str, &delay_tval);
+            continue;
+        }
+
+        /* Before any output: printf() is a cancellation point. */
+        pthread_cleanup_push(&unlock_demo_mutex_, NULL);
+
+        if (NULL == counters) {
             printf(" %s [%lu wakeups] pthread_mutex_lock() OK\n",
                    tinfo->config_str, num_wakeups);
-        } else {
-            printf(" %s [%lu wakeups] pthread_mutex_lock() failed, returning the errno value %d.\n",
-                   tinfo->config_str, num_wakeups, mutex_res);
         }
 
         cond_res = pthread_cond_wait(&demo_condvar, &demo_mutex);
         if (cond_res == 0) {
             ++num_wakeups;
-            printf(" %s [%lu wakeups] pthread_cond_wait() OK\n",
-                   tinfo->config_str, num_wakeups);
+            ucnt_inc(counters, UCNT_EVENTS);
         } else {
-            printf(" %s [%lu wakeups] pthread_cond_wait() failed, returning the errno value %d.\n",
-                   tinfo->config_str, num_wakeups, cond_res);
+            ucnt_inc(counters, UCNT_FAIL);
+        }
+        if (NULL == counters) {
+            if (cond_res == 0) {
+                printf(" %s [%lu wakeups] pthread_cond_wait() OK\n",
+                       tinfo->config_str, num_wakeups);
+            } else {
+                printf(" %s [%lu wakeups] pthread_cond_wait() failed, returning the errno value %d.\n",
+                       tinfo->config_str, num_wakeups, cond_res);
+            }
         }
 
+        pthread_cleanup_pop(0);
+
         mutex_res = pthread_mutex_unlock(&demo_mutex);
-        if (mutex_res == 0) {
-            printf(" %s [%lu wakeups] pthread_mutex_unlock() OK\n",
-                   tinfo->config_str, num_wakeups);
-        } else {
-            printf(" %s [%lu wakeups] pthread_mutex_unlock() failed, returning the errno value %d.\n",
-                   tinfo->config_str, num_wakeups, mutex_res);
+        if (mutex_res != 0) {
+            ucnt_inc(counters, UCNT_FAIL);
+        }
+        if (NULL == counters) {
+            if (mutex_res == 0) {
+                printf(" %s [%lu wakeups] pthread_mutex_unlock() OK\n",
+                       tinfo->config_str, num_wakeups);
+            } else {
+                printf(" %s [%lu wakeups] pthread_mutex_unlock() failed, returning the errno value %d.\n",
+                       tinfo->config_str, num_wakeups, mutex_res);
+            }
         }
 
         delay_(tinfo->config_str, &delay_tval);
@@ -723,6 +781,7 @@ static void *
 sem_wait_thread_func (void *arg)
 {
     uex_thread_info *const tinfo = arg;
+    ucnt_block *const  counters = counters_for_(tinfo);
 
     unsigned long  num_acquired = 0;
 
@@ -730,19 +789,29 @@ sem_wait_thread_func (void *arg)
     errno_t  swait_err;
 
     while (1) {
-        printf(" %s [acquired %lu times] Calling sem_wait()...\n",
-               tinfo->config_str, num_acquired);
+        ucnt_inc(counters, UCNT_CYCLES);
+
+        if (NULL == counters) {
+            printf(" %s [acquired %lu times] Calling sem_wait()...\n",
+                   tinfo->config_str, num_acquired);
+        }
 
         swait_res = sem_wait(&sem);
         swait_err = errno;
 
         if (swait_res == 0) {
             ++num_acquired;
-            printf(" %s [acquired %lu times] sem_wait() == 0: Semaphore acquired OK\n",
-                   tinfo->config_str, num_acquired);
+            ucnt_inc(counters, UCNT_EVENTS);
+            if (NULL == counters) {
+                printf(" %s [acquired %lu times] sem_wait() == 0: Semaphore acquired OK\n",
+                       tinfo->config_str, num_acquired);
+            }
         } else {
-            printf(" %s [acquired %lu times] sem_wait() failed with errno %d.\n",
-                   tinfo->config_str, num_acquired, swait_err);
+            ucnt_inc(counters, (EINTR == swait_err) ? UCNT_INTR : UCNT_FAIL);
+            if (NULL == counters) {
+                printf(" %s [acquired %lu times] sem_wait() failed with errno %d.\n",
+                       tinfo->config_str, num_acquired, swait_err);
+            }
         }
 
         delay_(tinfo->config_str, &delay_tval);
@@ -793,12 +862,98 @@ handle_arg (const char *arg)
 }
 
 
+static double
+parse_report_period_ (const char *data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    double  seconds;
+
+    errno = 0;
+    seconds = strtod(data, &end);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse report period '%s'\n",
+                data);
+        exit(11);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after report period %g\n",
+                end, seconds);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing report period '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+
+    if (seconds <= 0.0) {
+        fprintf(stderr, "Report period must be positive (got %g, original text was '%s')\n",
+                seconds, data);
+        exit(14);
+    }
+
+    return seconds;
+}
+
+static unsigned long
+parse_bench_count_ (const char *data, const char *what, unsigned long max_value)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(15);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(16);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(17);
+    }
+
+    if (0 == value || value > max_value) {
+        fprintf(stderr, "The %s must be between 1 and %lu.\n", what, max_value);
+        exit(18);
+    }
+
+    return value;
+}
+
+
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [mutexattr:...] <Threads:zero_or_many(cv...|s...)>\n");
+    fprintf(out_stream, "Usage: [mutexattr:...] [report:<Seconds_with_decimals>]"
+            " <Threads:zero_or_many(cv...|s...)>\n");
     fprintf(out_stream, "  The thread name prefix 'cv' stands for \"Condition Variable\".\n");
     fprintf(out_stream, "  The thread name prefix 's' stands for \"Semaphore\".\n");
+    fprintf(out_stream, "  'report:': the threads only count wakeups (no message for each step),\n"
+            "  a reporter thread shows the per-thread counters with this period.\n");
+    fprintf(out_stream, "Or, benchmark mode: [mutexattr:...] bench:<Round_trips>"
+            " [fanout:<Waiters>|herd:<Waiters>]\n");
+    fprintf(out_stream, "  Ping-pong between two threads, then one thread waking many (default 4),\n"
+            "  with each of: semaphore, condvar (signaling with/without the mutex held), futex;\n"
+            "  also a chain of condvars, and sharded condvars, for waking many.\n");
+    fprintf(out_stream, "  'herd:' skips the ping-pong; meant for hundreds of waiters (at most %d).\n",
+            UEX_THREADS_MAX);
 
     show_all_mutexattr_options(out_stream);
 }
@@ -813,6 +968,10 @@ main (int argc, char* argv[])
     mutexattr_parsing_info    mpinfo;
     mutexattr_setting_status  mstatus;
 
+    unsigned long  bench_rounds = 0;  /* zero: interactive */
+    unsigned long  fanout_waiters = 4;
+    int            herd_only = 0;
+
     int  arg_pos = 1;
     int  mattr_res;
     int  res;
@@ -849,6 +1008,56 @@ main (int argc, char* argv[])
         }
     }
 
+    if (arg_pos < argc) {
+        if (0 == strncmp("bench:", argv[arg_pos], 6)) {
+            data = argv[arg_pos] + 6;
+            bench_rounds = parse_bench_count_(data, "number of round trips", ULONG_MAX);
+            ++arg_pos;
+        }
+    }
+
+    if (bench_rounds > 0) {
+        if (arg_pos < argc && 0 == strncmp("fanout:", argv[arg_pos], 7)) {
+            data = argv[arg_pos] + 7;
+            fanout_waiters = parse_bench_count_(data, "number of waiters", UEX_THREADS_MAX);
+            ++arg_pos;
+        } else if (arg_pos < argc && 0 == strncmp("herd:", argv[arg_pos], 5)) {
+            data = argv[arg_pos] + 5;
+            fanout_waiters = parse_bench_count_(data, "number of waiters", UEX_THREADS_MAX);
+            herd_only = 1;
+            ++arg_pos;
+        }
+        if (arg_pos < argc) {
+            fprintf(stderr, "Unexpected argument '%s' in benchmark mode.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 4;
+        }
+
+        printf("Pid = %ld\n", (long) getpid());
+        if (req_mutexattr_p) {
+            show_mutexattr_settings(req_mutexattr_p, stdout);
+        }
+
+        if (!herd_only) {
+            run_pingpong_benchmarks(bench_rounds, req_mutexattr_p);
+        }
+        run_fanout_benchmarks(bench_rounds, (int) fanout_waiters, req_mutexattr_p);
+
+        if (req_mutexattr_p) {
+            pthread_mutexattr_destroy(req_mutexattr_p);
+        }
+        return 0;
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strncmp("report:", argv[arg_pos], 7)) {
+            data = argv[arg_pos] + 7;
+            report_period = parse_report_period_(data);
+            ++arg_pos;
+        }
+    }
+
     for (; arg_pos < argc; ++arg_pos) {
         res = handle_arg(argv[arg_pos]);
         if (res != 0) {
@@ -875,12 +1084,16 @@ main (int argc, char* argv[])
     }
 
     uex_start_threads();
+    if (report_period > 0.0) {
+        uex_start_reporter(report_period, stdout);  /* failure already reported */
+    }
 
     command_loop_();
 
     printf("\n");
     uex_cancel_threads();
     uex_join_threads();
+    uex_stop_reporter();
 
     printf("\nThe  %lu times.\n",
            0);
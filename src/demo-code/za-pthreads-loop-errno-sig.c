@@ -10,14 +10,30 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "loop-errno-sig.h"
+#include "util-counters.h"
 #include "util-ex-threads.h"
 #include "util-sigaction.h"
+#include "util-work-pool.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
 
 
 static void *
@@ -31,6 +47,134 @@ loop_err_thread_func (void *arg)
 }
 
 
+/*
+ * Pool mode.
+ */
+
+#define TASK_SPLIT_CALLS  256  /* a task with more calls gives away halves */
+
+static int            pool_workers = 0;  /* zero: no pool */
+static unsigned long  pool_tasks = 64;
+static unsigned long  pool_calls_per_task = 10000;
+
+static uwp_pool   *work_pool;
+static ucnt_block *pool_counters;  /* one block per worker */
+
+/*
+ * The argument is the number of calls to make, not a pointer.
+ */
+static void
+eacces_task_func (void *arg)
+{
+    ucnt_block *const counters = &pool_counters[uwp_current_worker()];
+
+    uintptr_t  n_calls = (uintptr_t) arg;
+    uintptr_t  half;
+
+    unsigned long  num_calls = 0;
+    unsigned long  num_unexpected;
+
+    /* Fork-join style: the halves given away go to the deque
+     * of this worker, where idle workers can steal them from.
+     */
+    while (n_calls > TASK_SPLIT_CALLS) {
+        half = n_calls / 2;
+        if (uwp_submit(work_pool, &eacces_task_func, (void *) half) != 0) {
+            break;  /* no memory: do it all here */
+        }
+        n_calls -= half;
+    }
+
+    num_unexpected = calls_expecting_eacces(n_calls, &num_calls);
+
+    ucnt_inc(counters, UCNT_CYCLES);  /* tasks */
+    ucnt_add(counters, UCNT_EVENTS, num_calls);
+    ucnt_add(counters, UCNT_FAIL, num_unexpected);
+}
+
+static void
+run_pool_tasks (void)
+{
+    int  res;
+
+    unsigned long long  total_tasks = 0;
+    unsigned long long  total_calls = 0;
+    unsigned long long  total_unexpected = 0;
+
+    unsigned long  ix;
+    int            w;
+
+    pool_counters = aligned_alloc(UCNT_CACHE_LINE, pool_workers * sizeof pool_counters[0]);
+    if (NULL == pool_counters) {
+        perror("aligned_alloc(pool_counters)");
+        exit(34);
+    }
+    memset(pool_counters, 0, pool_workers * sizeof pool_counters[0]);
+
+    work_pool = uwp_create(pool_workers);
+    if (NULL == work_pool) {
+        perror("uwp_create()");
+        exit(35);
+    }
+
+    printf("Submitting %lu tasks of %lu calls to a pool of %d workers ...\n",
+           pool_tasks, pool_calls_per_task, pool_workers);
+
+    for (ix = 0; ix < pool_tasks; ++ix) {
+        res = uwp_submit(work_pool, &eacces_task_func, (void *) (uintptr_t) pool_calls_per_task);
+        if (res != 0) {
+            fprintf(stderr, "uwp_submit() failed, returning the errno value %d = %s\n",
+                    res, strerror(res));
+            exit(36);
+        }
+    }
+
+    uwp_wait_idle(work_pool);
+
+    for (w = 0; w < pool_workers; ++w) {
+        total_tasks += ucnt_get(&pool_counters[w], UCNT_CYCLES);
+        total_calls += ucnt_get(&pool_counters[w], UCNT_EVENTS);
+        total_unexpected += ucnt_get(&pool_counters[w], UCNT_FAIL);
+    }
+
+    printf("Pool done: %llu tasks (after splitting), %llu calls made,"
+           " %llu cases of unexpected errno value.\n",
+           total_tasks, total_calls, total_unexpected);
+    uwp_show_stats(work_pool, "pool", stdout);
+
+    uwp_destroy(work_pool);
+    free(pool_counters);
+}
+
+
+/* Positive count, for the pool options; exits on anything else. */
+static unsigned long
+parse_count_ (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data || *end != '\0') {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(31);
+    }
+    if (strto_err != 0 || 0 == value) {
+        fprintf(stderr, "Bad %s '%s' (errno %d)\n",
+                what, data, strto_err);
+        exit(32);
+    }
+
+    return value;
+}
+
 /*
  * Handle Argument (usually coming from command-line interface).
  * Each argument should describe a thread to be created/started.
@@ -42,6 +186,25 @@ handle_arg (const char *arg)
 {
     int  pos;
 
+    if (0 == strncmp("pool:", arg, 5)) {
+        const unsigned long  n = parse_count_(arg + 5, "number of workers");
+
+        if (n > UWP_WORKERS_MAX) {
+            fprintf(stderr, "At most %d workers.\n", UWP_WORKERS_MAX);
+            exit(33);
+        }
+        pool_workers = (int) n;
+        return 0;
+    }
+    if (0 == strncmp("tasks:", arg, 6)) {
+        pool_tasks = parse_count_(arg + 6, "number of tasks");
+        return 0;
+    }
+    if (0 == strncmp("calls:", arg, 6)) {
+        pool_calls_per_task = parse_count_(arg + 6, "calls per task");
+        return 0;
+    }
+
     pos = uex_find_thread_config_by_prefix(arg, UEX_THREAD_CONFIG_MAX);
     if (pos >= 0) {
         fprintf(stderr, "Found thread config '%s' at %d\n", arg, pos);
@@ -82,7 +245,9 @@ parse_sa_flags_str (const char *data)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [sa_flags=...] <Threads:one_or_many(le...)>\n");
+    fprintf(out_stream, "Usage: [sa_flags=...] [pool:<Workers> [tasks:<N>] [calls:<N>]]"
+            " <Threads:zero_or_many(le...)>\n");
+    fprintf(out_stream, "  With a pool, the tasks run (and finish) before the threads start.\n");
     show_all_sigaction_flags(out_stream);
 }
 
@@ -129,6 +294,11 @@ main (int argc, char* argv[])
 
     register_loop_err_sigactions(sigact_flags);
 
+    /* Before blocking the interfering signals: the workers should get them. */
+    if (pool_workers > 0) {
+        run_pool_tasks();
+    }
+
     get_loop_err_sigset(&interfering_sigset);
     res = pthread_sigmask(SIG_BLOCK, &interfering_sigset, NULL);
     if (res != 0) {
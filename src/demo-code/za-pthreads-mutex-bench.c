@@ -0,0 +1,574 @@
+/*
+ * demo-code/za-pthreads-mutex-bench.c
+ *
+ * Mutex contention benchmark: N threads hammer a shared critical section,
+ * once for each set of mutex attributes (in the syntax of util-mutexattr);
+ * shows lock-acquire latency, throughput and fairness for each set.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "util-ex-threads.h"
+#include "util-latency.h"
+#include "util-mutexattr.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define RUNS_MAX  32  /* Maximum number of 'mutexattr:' arguments */
+
+/*
+ * Used when there are no 'mutexattr:' arguments;
+ * the empty string means "all defaults" (NULL attributes object).
+ */
+static const char *const  Default_Mutexattr_Strs[] = {
+    "",
+    "t=normal",
+    "t=errorcheck",
+    "t=recursive",
+    "t=normal,p=inherit",
+    "t=normal,robust",
+    "t=normal,pshared"
+};
+static const int  N_Default_Mutexattr_Strs =
+    sizeof Default_Mutexattr_Strs / sizeof Default_Mutexattr_Strs[0];
+
+
+static int     num_threads = 4;
+static double  duration_s = 1.0;
+static unsigned long  cs_work = 20;       /* work units inside the critical section */
+static unsigned long  outside_work = 100; /* work units between unlock and next lock */
+
+static const char *mutexattr_strs[RUNS_MAX];
+static int          num_runs = 0;
+
+
+/*
+ * State of the current run.  The threads only read the settings above,
+ * and write their own 'thread_stats' entry (found via 'pos').
+ */
+static pthread_mutex_t    bench_mutex;
+static pthread_barrier_t  start_barrier;
+static atomic_int         stop_flag;
+
+static unsigned long long  shared_counter;  /* protected by 'bench_mutex' */
+
+/*
+ * One cache line (or more) per thread: the counters written on every
+ * lock would otherwise share a line with the next entry, and the false
+ * sharing would be measured along with the mutex.
+ */
+typedef struct {
+    alignas(64) ulat_hist  ts_lock_hist;
+
+    unsigned long long  ts_acquired;
+    unsigned long long  ts_failed;
+    errno_t             ts_first_err;
+} thread_stats;
+
+static thread_stats *bench_stats;  /* 'num_threads' entries */
+
+
+typedef struct {
+    const char *rs_mutexattr_str;
+    int  rs_ok;
+
+    double  rs_acq_per_s;
+    double  rs_jain;
+    double  rs_max_min_ratio;
+
+    unsigned long long  rs_p50_ns;
+    unsigned long long  rs_p99_ns;
+    unsigned long long  rs_max_ns;
+} run_summary;
+
+static run_summary  run_summaries[RUNS_MAX];
+
+
+/*
+ * Some work that the compiler cannot optimize away;
+ * one unit is a few nanoseconds.
+ */
+static void
+spin_work_ (unsigned long n)
+{
+    volatile unsigned long  sink = 0;
+    unsigned long  ix;
+
+    for (ix = 0; ix < n; ++ix) {
+        sink += ix;
+    }
+}
+
+static void *
+hammer_thread_func (void *arg)
+{
+    uex_thread_info *const tinfo = arg;
+    thread_stats *const    tstats = &bench_stats[tinfo->pos];
+
+    unsigned long long  t_before;
+    unsigned long long  t_after;
+
+    errno_t  lock_res;
+
+    ulat_hist_reset(&tstats->ts_lock_hist);
+    tstats->ts_acquired = 0;
+    tstats->ts_failed = 0;
+    tstats->ts_first_err = 0;
+
+    pthread_barrier_wait(&start_barrier);
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        t_before = ulat_now_ns();
+        lock_res = pthread_mutex_lock(&bench_mutex);
+        t_after = ulat_now_ns();
+
+        if (EOWNERDEAD == lock_res) {  /* robust mutex; cannot happen here */
+            pthread_mutex_consistent(&bench_mutex);
+            lock_res = 0;
+        }
+        if (lock_res != 0) {
+            /* For example EINVAL for PRIO_PROTECT, if our priority is
+             * above the ceiling; retrying would fail the same way.
+             */
+            ++tstats->ts_failed;
+            tstats->ts_first_err = lock_res;
+            break;
+        }
+
+        ulat_hist_add(&tstats->ts_lock_hist, t_after - t_before);
+
+        ++shared_counter;
+        spin_work_(cs_work);
+
+        pthread_mutex_unlock(&bench_mutex);
+
+        ++tstats->ts_acquired;
+
+        spin_work_(outside_work);
+    }
+
+    return tinfo;
+}
+
+
+static int
+init_bench_mutex_ (const char *mutexattr_str)
+{
+    pthread_mutexattr_t  mattr;
+
+    mutexattr_parsing_info    mpinfo;
+    mutexattr_setting_status  mstatus;
+
+    errno_t  init_res;
+    int      res;
+
+    if ('\0' == mutexattr_str[0]) {
+        printf("Mutex attributes: defaults for all (NULL attr object).\n");
+        init_res = pthread_mutex_init(&bench_mutex, NULL);
+    } else {
+        memset(&mpinfo, 0, sizeof mpinfo);
+        res = parse_mutexattr_str(&mpinfo, mutexattr_str);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized mutex attr '%s' (error %d).\n",
+                    mpinfo.mp_rem, res);
+            return -1;
+        }
+
+        pthread_mutexattr_init(&mattr);
+
+        memset(&mstatus, 0, sizeof mstatus);
+        res = apply_mutexattr_settings(&mattr, &mstatus, &mpinfo);
+        if (res != 0) {
+            fprintf(stderr, "Failed to set mutex attributes (error %d).\n", res);
+            pthread_mutexattr_destroy(&mattr);
+            return -2;
+        }
+
+        printf("Mutex attributes (changed %u values out of %u parsed):\n",
+               mstatus.ms_num_changed, mpinfo.mp_num_parsed);
+        show_mutexattr_settings(&mattr, stdout);
+
+        init_res = pthread_mutex_init(&bench_mutex, &mattr);
+        pthread_mutexattr_destroy(&mattr);
+    }
+
+    if (init_res != 0) {
+        fprintf(stderr, "pthread_mutex_init() failed, returning the errno value %d = %s\n",
+                init_res, strerror(init_res));
+        return -3;
+    }
+
+    return 0;
+}
+
+static void
+run_one_ (int run_ix)
+{
+    run_summary *const  rs = &run_summaries[run_ix];
+
+    struct timespec  duration_tspec;
+
+    ulat_hist  all_lock_hist;
+    char       config_buf[UEX_THREAD_CONFIG_MAX + 1];
+    char       hist_preamble[64];
+
+    unsigned long long  t_start;
+    unsigned long long  t_stop;
+    unsigned long long  total = 0;
+    unsigned long long  acq_min = 0;
+    unsigned long long  acq_max = 0;
+    unsigned long long  acq;
+    unsigned long long  num_failed = 0;
+    errno_t             first_err = 0;
+
+    double  sum_sq = 0.0;
+    double  elapsed_s;
+
+    int  ix;
+    int  pos;
+
+    rs->rs_mutexattr_str = mutexattr_strs[run_ix];
+    rs->rs_ok = 0;
+
+    printf("\n=== Run %d/%d: mutexattr '%s', %d threads, %g s,"
+           " %lu work units inside / %lu outside the critical section\n",
+           run_ix + 1, num_runs, rs->rs_mutexattr_str, num_threads, duration_s,
+           cs_work, outside_work);
+
+    if (init_bench_mutex_(rs->rs_mutexattr_str) != 0) {
+        return;
+    }
+
+    uex_clear_thread_configs();
+    for (ix = 0; ix < num_threads; ++ix) {
+        snprintf(config_buf, sizeof config_buf, "t%d", ix);
+        pos = uex_add_thread_config(config_buf, NULL, &hammer_thread_func);
+        if (pos < 0) {
+            fprintf(stderr, "Could not add thread config '%s'\n", config_buf);
+            exit(8);
+        }
+    }
+
+    shared_counter = 0;
+    atomic_store(&stop_flag, 0);
+    pthread_barrier_init(&start_barrier, NULL, (unsigned) num_threads + 1);
+
+    if (uex_start_threads() != num_threads) {
+        /* the threads that did start wait at the barrier forever */
+        fprintf(stderr, "Could not start all the %d threads, giving up.\n", num_threads);
+        exit(9);
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    t_start = ulat_now_ns();
+
+    duration_tspec.tv_sec = (time_t) duration_s;
+    duration_tspec.tv_nsec = (long) ((duration_s - (double) duration_tspec.tv_sec) * 1e9);
+    while (nanosleep(&duration_tspec, &duration_tspec) != 0 && EINTR == errno) {
+        ;  /* keep sleeping the remaining time */
+    }
+
+    atomic_store(&stop_flag, 1);
+    t_stop = ulat_now_ns();
+
+    uex_join_threads();
+
+    pthread_barrier_destroy(&start_barrier);
+    pthread_mutex_destroy(&bench_mutex);
+
+    elapsed_s = (double) (t_stop - t_start) / 1e9;
+
+    ulat_hist_reset(&all_lock_hist);
+    for (ix = 0; ix < num_threads; ++ix) {
+        acq = bench_stats[ix].ts_acquired;
+
+        total += acq;
+        sum_sq += (double) acq * (double) acq;
+        if (0 == ix || acq < acq_min) {
+            acq_min = acq;
+        }
+        if (acq > acq_max) {
+            acq_max = acq;
+        }
+        num_failed += bench_stats[ix].ts_failed;
+        if (0 == first_err) {
+            first_err = bench_stats[ix].ts_first_err;
+        }
+
+        ulat_hist_merge(&all_lock_hist, &bench_stats[ix].ts_lock_hist);
+    }
+
+    if (num_failed > 0) {
+        printf("Lock failed in %llu threads (first error: %d = %s); no results.\n",
+               num_failed, first_err, strerror(first_err));
+        return;
+    }
+
+    printf("Acquired the mutex %llu times in %.3f s: %.0f/s;"
+           " the shared counter is %s (%llu).\n",
+           total, elapsed_s, (double) total / elapsed_s,
+           (shared_counter == total) ? "consistent" : "WRONG",
+           shared_counter);
+
+    for (ix = 0; ix < num_threads; ++ix) {
+        snprintf(hist_preamble, sizeof hist_preamble,
+                 "  t%d: %llu acquired; lock:", ix, bench_stats[ix].ts_acquired);
+        ulat_show_hist(&bench_stats[ix].ts_lock_hist, hist_preamble, stdout);
+    }
+    ulat_show_hist(&all_lock_hist, "  all threads, lock:", stdout);
+
+    rs->rs_ok = 1;
+    rs->rs_acq_per_s = (double) total / elapsed_s;
+    rs->rs_max_min_ratio = (acq_min > 0) ? (double) acq_max / (double) acq_min : 0.0;
+    /*
+     * Jain's fairness index: 1.0 when all threads got the mutex
+     * equally often, 1/N when one thread got it every time.
+     */
+    rs->rs_jain = (sum_sq > 0.0) ? (double) total * (double) total / (num_threads * sum_sq)
+                                 : 0.0;
+    rs->rs_p50_ns = ulat_hist_percentile(&all_lock_hist, 50.0);
+    rs->rs_p99_ns = ulat_hist_percentile(&all_lock_hist, 99.0);
+    rs->rs_max_ns = all_lock_hist.lh_max;
+
+    printf("Fairness: per-thread acquisitions min %llu, max %llu (max/min %.2f);"
+           " Jain's index %.4f\n",
+           acq_min, acq_max, rs->rs_max_min_ratio, rs->rs_jain);
+}
+
+static void
+show_summary_ (void)
+{
+    int  ix;
+
+    printf("\n=== Summary (%d threads, %g s per run; lock latency in usec):\n",
+           num_threads, duration_s);
+    printf("%-28s %12s %9s %9s %11s %8s %8s\n",
+           "mutexattr", "acquired/s", "p50", "p99", "max", "max/min", "Jain");
+
+    for (ix = 0; ix < num_runs; ++ix) {
+        const run_summary *const  rs = &run_summaries[ix];
+
+        if (!rs->rs_ok) {
+            printf("%-28s %12s\n",
+                   ('\0' == rs->rs_mutexattr_str[0]) ? "(defaults)" : rs->rs_mutexattr_str,
+                   "failed");
+            continue;
+        }
+
+        printf("%-28s %12.0f %9.3f %9.3f %11.3f %8.2f %8.4f\n",
+               ('\0' == rs->rs_mutexattr_str[0]) ? "(defaults)" : rs->rs_mutexattr_str,
+               rs->rs_acq_per_s,
+               rs->rs_p50_ns / 1e3, rs->rs_p99_ns / 1e3, rs->rs_max_ns / 1e3,
+               rs->rs_max_min_ratio, rs->rs_jain);
+    }
+}
+
+
+static unsigned long
+parse_ulong (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(11);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+
+    return value;
+}
+
+static double
+parse_seconds (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    double  seconds;
+
+    errno = 0;
+    seconds = strtod(data, &end);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(21);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %g\n",
+                end, what, seconds);
+        exit(22);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(23);
+    }
+
+    if (seconds <= 0.0) {
+        fprintf(stderr, "The %s must be positive (got %g, original text was '%s')\n",
+                what, seconds, data);
+        exit(24);
+    }
+
+    return seconds;
+}
+
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg (const char *arg)
+{
+    const char *data;
+
+    unsigned long  value;
+
+    if (0 == strncmp("threads:", arg, 8)) {
+        data = arg + 8;
+        value = parse_ulong(data, "number of threads");
+        if (value < 1 || value > UEX_THREADS_MAX) {
+            fprintf(stderr, "Number of threads must be between 1 and %d (got %lu).\n",
+                    UEX_THREADS_MAX, value);
+            exit(14);
+        }
+        num_threads = (int) value;
+    }
+    else if (0 == strncmp("duration:", arg, 9)) {
+        data = arg + 9;
+        duration_s = parse_seconds(data, "duration");
+    }
+    else if (0 == strncmp("cs:", arg, 3)) {
+        data = arg + 3;
+        cs_work = parse_ulong(data, "critical section work");
+    }
+    else if (0 == strncmp("outside:", arg, 8)) {
+        data = arg + 8;
+        outside_work = parse_ulong(data, "outside work");
+    }
+    else if (0 == strncmp("mutexattr:", arg, 10)) {
+        if (num_runs >= RUNS_MAX) {
+            fprintf(stderr, "Too many 'mutexattr:' arguments (max %d).\n", RUNS_MAX);
+            exit(15);
+        }
+        mutexattr_strs[num_runs++] = arg + 10;
+    }
+    else {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    int  ix;
+
+    fprintf(out_stream, "Usage: [threads:<N>] [duration:<Seconds_with_decimals>]"
+            " [cs:<Work_units>] [outside:<Work_units>] <zero_or_many(mutexattr:...)>\n");
+    fprintf(out_stream, "  One run for each 'mutexattr:' argument ('mutexattr:' alone"
+            " means all defaults);\n"
+            "  without any, the runs use these:");
+    for (ix = 0; ix < N_Default_Mutexattr_Strs; ++ix) {
+        fprintf(out_stream, " '%s'", Default_Mutexattr_Strs[ix]);
+    }
+    fprintf(out_stream, "\n");
+
+    show_all_mutexattr_options(out_stream);
+}
+
+int
+main (int argc, char* argv[])
+{
+    int  arg_pos;
+    int  res;
+    int  ix;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s' (error %d).\n",
+                    argv[arg_pos], res);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+
+    if (0 == num_runs) {
+        for (ix = 0; ix < N_Default_Mutexattr_Strs; ++ix) {
+            mutexattr_strs[num_runs++] = Default_Mutexattr_Strs[ix];
+        }
+    }
+
+    /* calloc() only aligns for the basic types: not enough for 'alignas(64)'. */
+    res = posix_memalign((void **) &bench_stats, alignof(thread_stats),
+                         (size_t) num_threads * sizeof bench_stats[0]);
+    if (res != 0) {
+        fprintf(stderr, "posix_memalign(bench_stats) failed, returning the errno value %d = %s\n",
+                res, strerror(res));
+        return 3;
+    }
+    memset(bench_stats, 0, (size_t) num_threads * sizeof bench_stats[0]);
+
+    uex_set_quiet(1);  /* the per-thread results say enough */
+
+    for (ix = 0; ix < num_runs; ++ix) {
+        run_one_(ix);
+    }
+
+    show_summary_();
+
+    free(bench_stats);
+
+    return 0;
+}
@@ -16,6 +16,7 @@
 #include <unistd.h>
 
 #include "loop-handling-sig.h"
+#include "util-async-log.h"
 #include "util-ex-threads.h"
 #include "util-sigaction.h"
 
@@ -35,13 +36,36 @@
 
 static double  cycle_time = 2.4;
 
+/*
+ * Zero: each thread shows every signal it handles.
+ * Positive: the threads only update their counters, and
+ * a reporter thread shows them every 'report_period' seconds.
+ */
+static double  report_period = 0.0;
+
+static ucnt_block *
+counters_for_ (uex_thread_info *tinfo)
+{
+    return (report_period > 0.0) ? &tinfo->counters : NULL;
+}
+
 
 static void *
 waiting_signal_thread_func (void *arg)
 {
     uex_thread_info *const tinfo = arg;
 
-    loop_waiting_signal(tinfo->config_str, cycle_time);
+    loop_waiting_signal(tinfo->config_str, cycle_time, counters_for_(tinfo));
+
+    return tinfo;
+}
+
+static void *
+reading_signalfd_thread_func (void *arg)
+{
+    uex_thread_info *const tinfo = arg;
+
+    loop_reading_signalfd(tinfo->config_str, cycle_time, counters_for_(tinfo));
 
     return tinfo;
 }
@@ -51,7 +75,7 @@ sleeping_thread_func (void *arg)
 {
     uex_thread_info *const tinfo = arg;
 
-    loop_sleeping(tinfo->config_str, cycle_time);
+    loop_sleeping(tinfo->config_str, cycle_time, counters_for_(tinfo));
 
     return tinfo;
 }
@@ -88,6 +112,13 @@ handle_arg (const char *arg)
             exit(8);
         }
     }
+    else if (0 == strncmp("f", arg, 1)) { /* The prefix 'f' stands for "signalFd" */
+        pos = uex_add_thread_config(arg, NULL, &reading_signalfd_thread_func);
+        if (pos < 0) {
+            fprintf(stderr, "Could not add thread config '%s'\n", arg);
+            exit(9);
+        }
+    }
     else {
         return -1;
     }
@@ -150,15 +181,61 @@ parse_cycle_time (const char *data)
 }
 
 
+static double
+parse_report_period (const char *data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    double  seconds;
+
+    errno = 0;
+    seconds = strtod(data, &end);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse report period '%s'\n",
+                data);
+        exit(15);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after report period %g\n",
+                end, seconds);
+        exit(16);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing report period '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(17);
+    }
+
+    if (seconds <= 0.0) {
+        fprintf(stderr, "Report period must be positive (got %g, original text was '%s')\n",
+                seconds, data);
+        exit(18);
+    }
+
+    return seconds;
+}
+
+
 static void
 show_usage (FILE *out_stream)
 {
     fprintf(out_stream, "Usage: [sa_flags=...]"
             " [cycle_time=<Seconds_with_decimals>]"
-            " <Threads:one_or_many(w...|s...)>\n");
+            " [report=<Seconds_with_decimals>] [asynclog]"
+            " <Threads:one_or_many(w...|s...|f...)>\n");
 
     fprintf(out_stream, "  The thread name prefix 'w' stands for \"Waiting\".\n");
     fprintf(out_stream, "  The thread name prefix 's' stands for \"Sleeping\".\n");
+    fprintf(out_stream, "  The thread name prefix 'f' stands for \"signalFd\""
+            " (reading batches of signals, waiting with epoll).\n");
+    fprintf(out_stream, "  'report=': the threads only count signals (no message for each),\n"
+            "  a reporter thread shows the per-thread counters with this period.\n");
+    fprintf(out_stream, "  'asynclog': the threads queue their messages to a background writer thread\n"
+            "  (see util-async-log.h) instead of taking the stdio lock for each.\n");
 
     show_all_sigaction_flags(out_stream);
 }
@@ -173,6 +250,8 @@ main (int argc, char* argv[])
     int  res;
     const char *data;
 
+    int  want_async_log = 0;
+
     if (arg_pos < argc) {
         if (0 == strncmp("sa_flags=", argv[arg_pos], 9)) {
             data = argv[arg_pos] + 9;
@@ -189,6 +268,21 @@ main (int argc, char* argv[])
         }
     }
 
+    if (arg_pos < argc) {
+        if (0 == strncmp("report=", argv[arg_pos], 7)) {
+            data = argv[arg_pos] + 7;
+            report_period = parse_report_period(data);
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strcmp("asynclog", argv[arg_pos])) {
+            want_async_log = 1;
+            ++arg_pos;
+        }
+    }
+
     for (; arg_pos < argc; ++arg_pos) {
         res = handle_arg(argv[arg_pos]);
         if (res != 0) {
@@ -214,8 +308,26 @@ main (int argc, char* argv[])
         return 3;
     }
 
+    if (want_async_log) {
+        res = ualog_start();
+        if (res != 0) {
+            fprintf(stderr, "Could not start the async log: errno %d = %s\n",
+                    res, strerror(res));
+            return 4;
+        }
+    }
+
     uex_start_threads();
+    if (report_period > 0.0) {
+        /* On failure (already reported) the threads still count quietly;
+         * the totals are shown at the end anyway, by each loop.
+         */
+        uex_start_reporter(report_period, stdout);
+    }
+
     uex_join_threads();
+    uex_stop_reporter();
+    ualog_stop(stdout);
 
     printf("\nThe signal handler executed %lu times.\n",
            get_num_handled_async());
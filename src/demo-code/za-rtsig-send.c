@@ -3,6 +3,7 @@
  *
  */
 
+#define _DEFAULT_SOURCE  /* for syscall() */
 #include <assert.h>
 #include <errno.h>
 #include <limits.h>  /* for 'INT_MAX', etc. */
@@ -10,9 +11,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/select.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "util-latency.h"
 #include "util-timeval.h"
 
 /*
@@ -100,6 +105,7 @@ delay_ (const struct timeval *delay_tval)
 static unsigned long   burst_size = 1;
 static struct timeval  delay_between_bursts_tval;
 static int  want_delay_between_bursts = 1;
+static int  delay_specified = 0;
 
 static int  target_pid = 0;
 static int  the_signo = 0;
@@ -107,6 +113,11 @@ static int  the_signo = 0;
 static int  incr_signal_value = 0;
 static int  curr_signal_value = 0;  /* May be changed after each signal sent */
 
+/* Send the CLOCK_MONOTONIC time (low 32 bits) in 'sival_int' instead of
+ * 'curr_signal_value', so receivers can measure delivery latency:
+ */
+static int  want_timestamps = 0;
+
 static unsigned long long  num_calls = 0;
 static unsigned long long  num_sent = 0;
 
@@ -120,6 +131,41 @@ soft_stop_handler (int signo)
 }
 
 
+static int  want_raw_syscall = 0;
+
+/* Filled once by prepare_raw_siginfo_(), only 'si_value' changes later: */
+static siginfo_t  raw_siginfo;
+
+static void
+prepare_raw_siginfo_ (void)
+{
+    memset(&raw_siginfo, 0, sizeof raw_siginfo);
+
+    raw_siginfo.si_signo = the_signo;
+    raw_siginfo.si_code = SI_QUEUE;
+    raw_siginfo.si_pid = getpid();
+    raw_siginfo.si_uid = getuid();
+}
+
+/*
+ * glibc's sigqueue() fills a siginfo_t calling getpid() and getuid()
+ * every time, then makes the rt_sigqueueinfo syscall: three syscalls
+ * per signal.  The 'raw' variant makes only the last one, with
+ * the siginfo_t prepared in advance --- the receiver cannot tell
+ * the difference (same si_code, si_pid, si_uid and si_value).
+ */
+static int
+send_one_ (union sigval val)
+{
+    if (want_raw_syscall) {
+        raw_siginfo.si_value = val;
+        return (int) syscall(SYS_rt_sigqueueinfo, target_pid, the_signo, &raw_siginfo);
+    }
+
+    return sigqueue(target_pid, the_signo, val);
+}
+
+
 /* Returning zero or positive value means relatively successful =
  * caller may repeat or try again (send another burst):
  */
@@ -144,8 +190,12 @@ send_burst (void)
 
         curr_signal_value += incr_signal_value;
 
+        if (want_timestamps) {
+            val.sival_int = (int) ulat_stamp32();
+        }
+
         errno = 0;
-        my_res = sigqueue(target_pid, the_signo, val);
+        my_res = send_one_(val);
         my_err = errno;
         ++num_calls;
 
@@ -211,6 +261,292 @@ loop_sending (void)
 }
 
 
+/*
+ * Benchmark mode ('bench' argument): the bursts are sent without any stdio,
+ * so we measure the kernel path (and how fast the receiver drains its queue),
+ * not printf.  Results are shown only between bursts, if a report interval
+ * was requested, and at the end.
+ */
+static int  want_bench = 0;
+
+static double  duration_s = 0.0;  /* zero = until SIGINT */
+static double  report_interval_s = 0.0;  /* zero = show results only at the end */
+
+static ulat_hist  burst_hist;  /* duration of each burst, backoff included */
+static ulat_hist  backoff_hist;  /* from first EAGAIN until the signal was queued */
+
+static unsigned long long  num_eagain = 0;
+static unsigned long long  num_backoff_episodes = 0;
+static unsigned long long  max_eagain_streak = 0;
+
+static errno_t  last_send_err = 0;  /* reported after the loop */
+
+/*
+ * EAGAIN means the limit on queued signals was reached
+ * (RLIMIT_SIGPENDING, counted per real user ID): the receiver must
+ * dequeue some before we can queue more.  Retrying immediately would
+ * only burn CPU that the receiver might need, so we sleep, starting
+ * with a very short delay and doubling it while EAGAIN persists.
+ */
+static const long  Backoff_Min_ns = 1000L;  /* 1 microsecond */
+static const long  Backoff_Max_ns = 1000000L;  /* 1 millisecond */
+
+static void
+backoff_sleep_ (long delay_ns)
+{
+    struct timespec  tspec;
+
+    tspec.tv_sec = 0;
+    tspec.tv_nsec = delay_ns;
+
+    nanosleep(&tspec, NULL);  /* EINTR is fine: we check 'stop_sig' anyway */
+}
+
+/*
+ * Same contract as send_burst(), but without stdio; the errno value of
+ * a failure that cannot be retried is kept in 'last_send_err'.
+ */
+static int
+send_burst_quiet_ (void)
+{
+    unsigned long  ix;
+
+    unsigned long long  streak;
+    unsigned long long  episode_start_ns = 0;
+    long  backoff_ns;
+
+    union sigval  val;
+
+    int      my_res;
+    errno_t  my_err;
+
+    for (ix = 0; ix < burst_size && stop_sig == 0; ++ix) {
+        val.sival_int = curr_signal_value;
+
+        curr_signal_value += incr_signal_value;
+
+        streak = 0;
+        backoff_ns = Backoff_Min_ns;
+
+        while (1) {
+            if (want_timestamps) {
+                /* Stamp every attempt: we measure delivery, not our backoff. */
+                val.sival_int = (int) ulat_stamp32();
+            }
+
+            errno = 0;
+            my_res = send_one_(val);
+            my_err = errno;
+            ++num_calls;
+
+            if (my_res == 0) {
+                ++num_sent;
+                break;
+            }
+
+            if (my_err != EAGAIN) {
+                last_send_err = my_err;
+                return -1000;
+            }
+
+            if (0 == streak) {
+                ++num_backoff_episodes;
+                episode_start_ns = ulat_now_ns();
+            }
+            ++streak;
+            ++num_eagain;
+
+            if (stop_sig != 0) {
+                return 1;
+            }
+
+            backoff_sleep_(backoff_ns);
+            if (backoff_ns < Backoff_Max_ns) {
+                backoff_ns *= 2;
+            }
+        }
+
+        if (streak > 0) {
+            ulat_hist_add(&backoff_hist, ulat_now_ns() - episode_start_ns);
+            if (streak > max_eagain_streak) {
+                max_eagain_streak = streak;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * The "SigQ:" line from /proc/<pid>/status shows "queued/limit" for
+ * the real user ID of that process: the numbers behind our EAGAINs.
+ */
+static void
+show_target_sigq_ (FILE *out_stream)
+{
+    char  path[64];
+    char  line[256];
+
+    FILE *status_stream;
+
+    snprintf(path, sizeof path, "/proc/%d/status", target_pid);
+
+    status_stream = fopen(path, "r");
+    if (NULL == status_stream) {
+        fprintf(out_stream, "Could not open '%s': %s\n",
+                path, strerror(errno));
+        return;
+    }
+
+    while (fgets(line, sizeof line, status_stream)) {
+        if (0 == strncmp("SigQ:", line, 5)) {
+            fprintf(out_stream, "Target pid %d, queued/limit %s",
+                    target_pid, line);
+            break;
+        }
+    }
+
+    fclose(status_stream);
+}
+
+static void
+show_rlimit_sigpending_ (FILE *out_stream)
+{
+    struct rlimit  rlim;
+
+    if (getrlimit(RLIMIT_SIGPENDING, &rlim) != 0) {
+        perror("getrlimit(RLIMIT_SIGPENDING)");
+        return;
+    }
+
+    fprintf(out_stream, "RLIMIT_SIGPENDING: soft ");
+    if (RLIM_INFINITY == rlim.rlim_cur) {
+        fprintf(out_stream, "unlimited");
+    } else {
+        fprintf(out_stream, "%llu", (unsigned long long) rlim.rlim_cur);
+    }
+    fprintf(out_stream, ", hard ");
+    if (RLIM_INFINITY == rlim.rlim_max) {
+        fprintf(out_stream, "unlimited");
+    } else {
+        fprintf(out_stream, "%llu", (unsigned long long) rlim.rlim_max);
+    }
+    fprintf(out_stream, ".\n");
+}
+
+static void
+show_bench_results_ (FILE *out_stream,
+                     unsigned long num_bursts, unsigned long long elapsed_ns)
+{
+    const double  elapsed_s = (double) elapsed_ns / 1e9;
+
+    fprintf(out_stream, "\n%lu bursts in %.3f seconds: %llu calls, %llu signals queued,"
+            " %.0f signals/second (%s).\n",
+            num_bursts, elapsed_s, num_calls, num_sent,
+            elapsed_s > 0.0 ? (double) num_sent / elapsed_s : 0.0,
+            want_raw_syscall ? "raw rt_sigqueueinfo" : "sigqueue");
+
+    ulat_show_hist(&burst_hist, "Burst duration:", out_stream);
+
+    if (num_sent > 0) {
+        fprintf(out_stream, "Mean time per queued signal, backoff included: %.3f usec.\n",
+                (double) burst_hist.lh_sum / (double) num_sent / 1e3);
+    }
+
+    fprintf(out_stream, "EAGAIN: %llu times, in %llu backoff episodes"
+            " (longest episode: %llu retries).\n",
+            num_eagain, num_backoff_episodes, max_eagain_streak);
+    ulat_show_hist(&backoff_hist, "Backoff episode duration:", out_stream);
+
+    show_target_sigq_(out_stream);
+}
+
+static void
+loop_sending_bench_ (void)
+{
+    unsigned long  num_bursts = 0;
+
+    const unsigned long long  report_interval_ns =
+        (unsigned long long) (report_interval_s * 1e9);
+
+    unsigned long long  start_ns;
+    unsigned long long  deadline_ns = 0;
+    unsigned long long  next_report_ns = 0;
+    unsigned long long  burst_start_ns;
+    unsigned long long  now_ns;
+
+    unsigned long long  prev_report_ns;
+    unsigned long long  prev_report_sent = 0;
+
+    int  res = 0;
+
+    ulat_hist_reset(&burst_hist);
+    ulat_hist_reset(&backoff_hist);
+
+    show_rlimit_sigpending_(stdout);
+    show_target_sigq_(stdout);
+    fflush(stdout);
+
+    start_ns = ulat_now_ns();
+    prev_report_ns = start_ns;
+
+    if (duration_s > 0.0) {
+        deadline_ns = start_ns + (unsigned long long) (duration_s * 1e9);
+    }
+    if (report_interval_ns > 0) {
+        next_report_ns = start_ns + report_interval_ns;
+    }
+
+    while (stop_sig == 0) {
+        burst_start_ns = ulat_now_ns();
+        res = send_burst_quiet_();
+        now_ns = ulat_now_ns();
+        ++num_bursts;
+
+        ulat_hist_add(&burst_hist, now_ns - burst_start_ns);
+
+        if (res < 0) {
+            break;
+        }
+        if (deadline_ns > 0 && now_ns >= deadline_ns) {
+            break;
+        }
+
+        if (report_interval_ns > 0 && now_ns >= next_report_ns) {
+            printf("[%.1f s] %llu signals queued (%.0f/second since last report), %llu EAGAIN\n",
+                   (double) (now_ns - start_ns) / 1e9, num_sent,
+                   (double) (num_sent - prev_report_sent) * 1e9
+                       / (double) (now_ns - prev_report_ns),
+                   num_eagain);
+            fflush(stdout);
+
+            prev_report_ns = now_ns;
+            prev_report_sent = num_sent;
+            next_report_ns = now_ns + report_interval_ns;
+        }
+
+        if (want_delay_between_bursts) {
+            delay_(&delay_between_bursts_tval);
+        }
+    }
+
+    now_ns = ulat_now_ns();
+
+    if (res < 0) {
+        fprintf(stderr, "\nsigqueue(sival_int=%d) failed, unlikely to work if we try again:"
+                " errno %d = %s\n",
+                curr_signal_value - incr_signal_value,
+                last_send_err, strerror(last_send_err));
+    }
+    if (stop_sig != 0) {
+        printf("\nStopped by signal %d.\n", stop_sig);
+    }
+
+    show_bench_results_(stdout, num_bursts, now_ns - start_ns);
+}
+
+
 static void
 register_soft_stop_handler (void)
 {
@@ -489,6 +825,44 @@ parse_delay (const char *data)
     return delay;
 }
 
+static double
+parse_seconds (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    double  seconds;
+
+    errno = 0;
+    seconds = strtod(data, &end);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(71);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %g\n",
+                end, what, seconds);
+        exit(72);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(73);
+    }
+
+    if (seconds < 0.0) {
+        fprintf(stderr, "The %s must be positive or zero (got %g, original text was '%s')\n",
+                what, seconds, data);
+        exit(74);
+    }
+
+    return seconds;
+}
+
 
 /*
  * Handle Argument (usually coming from command-line interface).
@@ -536,7 +910,25 @@ handle_arg (const char *arg)
         data = arg + 6;
         delay = parse_delay(data);
         fill_timeval_from_double(&delay_between_bursts_tval, delay);
-        want_delay_between_bursts = 1;
+        want_delay_between_bursts = (delay > 0.0);
+        delay_specified = 1;
+    }
+    else if (0 == strcmp("stamp", arg)) {
+        want_timestamps = 1;
+    }
+    else if (0 == strcmp("raw", arg)) {
+        want_raw_syscall = 1;
+    }
+    else if (0 == strcmp("bench", arg)) {
+        want_bench = 1;
+    }
+    else if (0 == strncmp("duration:", arg, 9)) {
+        data = arg + 9;
+        duration_s = parse_seconds(data, "duration");
+    }
+    else if (0 == strncmp("report:", arg, 7)) {
+        data = arg + 7;
+        report_interval_s = parse_seconds(data, "report interval");
     }
     else {
         return -1;
@@ -551,7 +943,14 @@ show_usage (FILE *out_stream)
 {
     fprintf(out_stream, "Usage: <Signo>  to:<Pid>\n"
             "  [val:<N>]  [incr | incr:<Step> | decr | decr:<Step>]\n"
-            "  [burst:<Burst_Size>]  [delay:<Seconds_with_decimals>]\n");
+            "  [burst:<Burst_Size>]  [delay:<Seconds_with_decimals>]  [raw]  [stamp]\n"
+            "  [bench  [duration:<Seconds>]  [report:<Seconds>]]\n"
+            "'raw' sends with the rt_sigqueueinfo syscall directly (one syscall per signal).\n"
+            "'stamp' sends the send time (CLOCK_MONOTONIC, low 32 bits of nanoseconds)\n"
+            "  as the value, for receivers started with the 'latency' argument.\n"
+            "'bench' sends without any output until stopped (SIGINT or duration),\n"
+            "  then shows signals/second, burst duration percentiles and EAGAIN backoff;\n"
+            "  no delay between bursts unless 'delay:' is given.\n");
 }
 
 static void
@@ -562,8 +961,12 @@ show_settings (FILE *out_stream)
     fprintf(out_stream, "Signal number: %d;\n",
             the_signo);
 
-    fprintf(out_stream, "Value to send: %d;\n",
-            curr_signal_value);
+    if (want_timestamps) {
+        fprintf(out_stream, "Value to send: send time (stamp);\n");
+    } else {
+        fprintf(out_stream, "Value to send: %d;\n",
+                curr_signal_value);
+    }
     fprintf(out_stream, "Value change step: %d (the value could be incremented or decremented);\n",
             incr_signal_value);
 
@@ -574,8 +977,19 @@ show_settings (FILE *out_stream)
     show_timeval(&delay_between_bursts_tval, out_stream);
     fprintf(out_stream, ";\n");
 
-    fprintf(out_stream, "Want delay between bursts: %d.\n",
+    fprintf(out_stream, "Want delay between bursts: %d;\n",
             want_delay_between_bursts);
+
+    fprintf(out_stream, "Sending with: %s;\n",
+            want_raw_syscall ? "rt_sigqueueinfo syscall (raw)" : "sigqueue()");
+
+    if (want_bench) {
+        fprintf(out_stream, "Benchmark mode: duration %g seconds (zero = until SIGINT),"
+                " report every %g seconds (zero = only at the end).\n",
+                duration_s, report_interval_s);
+    } else {
+        fprintf(out_stream, "Benchmark mode: off.\n");
+    }
 }
 
 int
@@ -610,11 +1024,25 @@ main (int argc, char* argv[])
         return 3;
     }
 
+    if (want_bench && !delay_specified) {
+        want_delay_between_bursts = 0;
+        fill_timeval_from_double(&delay_between_bursts_tval, 0.0);
+    }
+
+    if (want_raw_syscall) {
+        prepare_raw_siginfo_();
+    }
+
     show_settings(stdout);
     printf("\nMy Pid = %ld\n", (long) getpid());
 
     register_soft_stop_handler();
-    loop_sending();
+
+    if (want_bench) {
+        loop_sending_bench_();
+    } else {
+        loop_sending();
+    }
 
     return 0;
 }
@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include "loop-handling-sig.h"
+#include "util-async-log.h"
 #include "util-sigaction.h"
 
 /*
@@ -24,6 +25,7 @@
 
 
 static int  block = 0;
+static int  use_signalfd = 0;
 
 
 static int
@@ -83,7 +85,20 @@ parse_cycle_time (const char *data)
 static void
 show_usage (FILE *out_stream)
 {
-    fprintf(out_stream, "Usage: [sa_flags=...] [cycle_time=<Seconds_with_decimals>] [block]\n");
+    fprintf(out_stream, "Usage: [sa_flags=...] [cycle_time=<Seconds_with_decimals>] [block] [signalfd] [latency [messages] [asynclog]] [trace]\n");
+    fprintf(out_stream, "  'signalfd': read the signals in batches from a signalfd"
+            " (waiting with epoll)\n"
+            "  instead of one sigtimedwait() call per signal; implies 'block'.\n");
+    fprintf(out_stream, "  'latency': expect signals from 'za-rtsig-send stamp',"
+            " show delivery latency percentiles\n"
+            "  instead of each signal (implies the 'i' = SA_SIGINFO flag).\n");
+    fprintf(out_stream, "  'messages': show each signal anyway, to measure what that costs.\n");
+    fprintf(out_stream, "  'asynclog': queue the messages to a background writer thread"
+            " instead of printing them\n"
+            "  (see util-async-log.h).\n");
+    fprintf(out_stream, "  'trace': the handler records each signal in a lock-free ring,"
+            " dumped after each wakeup\n"
+            "  (see util-sig-trace.h).\n");
     show_all_sigaction_flags(out_stream);
 }
 
@@ -101,6 +116,11 @@ main (int argc, char* argv[])
 
     double  cycle_time = 2.4;
 
+    int  want_latency = 0;
+    int  want_messages = 0;
+    int  want_async_log = 0;
+    int  want_trace = 0;
+
     if (arg_pos < argc) {
         if (0 == strncmp("sa_flags=", argv[arg_pos], 9)) {
             data = argv[arg_pos] + 9;
@@ -124,6 +144,42 @@ main (int argc, char* argv[])
         }
     }
 
+    if (arg_pos < argc) {
+        if (0 == strcmp("signalfd", argv[arg_pos])) {
+            use_signalfd = 1;
+            block = 1;  /* unblocked signals would not be queued for the signalfd */
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strcmp("latency", argv[arg_pos])) {
+            want_latency = 1;
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strcmp("messages", argv[arg_pos])) {
+            want_messages = 1;
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strcmp("asynclog", argv[arg_pos])) {
+            want_async_log = 1;
+            ++arg_pos;
+        }
+    }
+
+    if (arg_pos < argc) {
+        if (0 == strcmp("trace", argv[arg_pos])) {
+            want_trace = 1;
+            ++arg_pos;
+        }
+    }
+
     if (arg_pos < argc) {
         fprintf(stderr, "Unrecognized argument '%s'.\n",
                 argv[arg_pos]);
@@ -134,6 +190,17 @@ main (int argc, char* argv[])
     printf("Pid = %ld\n", (long) getpid());
     printf("SIGRTMIN = %d, SIGRTMAX = %d\n", SIGRTMIN, SIGRTMAX);
 
+    if (want_latency) {
+        enable_loop_handlesig_latency_stats();
+        sigact_flags |= SA_SIGINFO;  /* the handler needs 'si_value' */
+    }
+    if (want_messages) {
+        enable_loop_handlesig_messages();
+    }
+    if (want_trace) {
+        enable_loop_handlesig_trace();
+    }
+
     show_sigaction_flags(sigact_flags, stdout);
 
     if (block) {
@@ -150,10 +217,30 @@ main (int argc, char* argv[])
 
     register_loop_handlesig_sigactions(sigact_flags);
 
-    loop_waiting_signal("", cycle_time);
+    if (want_async_log) {
+        /* after blocking the signals: the writer thread inherits the mask */
+        res = ualog_start();
+        if (res != 0) {
+            fprintf(stderr, "Could not start the async log: errno %d = %s\n",
+                    res, strerror(res));
+            return 4;
+        }
+    }
+
+    if (use_signalfd) {
+        loop_reading_signalfd("", cycle_time, NULL);
+    } else {
+        loop_waiting_signal("", cycle_time, NULL);
+    }
+
+    ualog_stop(stdout);
 
     printf("\nThe signal handler executed %lu times.\n",
            get_num_handled_async());
 
+    if (want_latency) {
+        show_async_latency_stats("", stdout);
+    }
+
     return 0;
 }
@@ -0,0 +1,333 @@
+/*
+ * demo-code/za-spawn-bench.c
+ *
+ * Spawning a small program (za-true1 by default) from a parent with
+ * a large dirty resident set, four ways: fork() + exec(), vfork() + exec(),
+ * posix_spawn(), and clone(CLONE_VM | CLONE_VFORK) + exec().
+ *
+ * fork() copies the page tables of the parent (and marks every page
+ * copy-on-write), so its cost grows with the resident set; the others
+ * share the address space of the parent until the child calls exec(),
+ * which glibc's posix_spawn() also does, with clone() internally.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _GNU_SOURCE  /* for clone() and vfork() */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+/* for the clone() child, until it calls exec() */
+#define CHILD_STACK_SIZE  (64 * 1024)
+
+extern char **environ;
+
+static const char *prog_path = "./za-true1";
+
+static unsigned long  runs = 1000;
+static unsigned long  rss_mib = 1024;
+
+typedef enum {
+    SPAWN_FORK,
+    SPAWN_VFORK,
+    SPAWN_POSIX_SPAWN,
+    SPAWN_CLONE_VM,
+    SPAWN_N_KINDS
+} spawn_kind;
+
+static const char *const Kind_Names[SPAWN_N_KINDS] = {
+    "fork+exec",
+    "vfork+exec",
+    "posix_spawn",
+    "clone(VM|VFORK)+exec"
+};
+
+
+static unsigned long
+parse_count_ (const char *data, const char *what)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse %s '%s'\n",
+                what, data);
+        exit(11);
+    }
+
+    /* Optional suffix for sizes (in MiB): G = GiB */
+    if ('g' == *end || 'G' == *end) {
+        value *= 1024;
+        ++end;
+    }
+
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after %s %lu\n",
+                end, what, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing %s '%s' failed with errno %d: %s\n",
+                what, data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+
+    return value;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    if (0 == strncmp("runs:", arg, 5)) {
+        runs = parse_count_(arg + 5, "runs");
+        if (0 == runs) {
+            fprintf(stderr, "The number of runs must be above 0.\n");
+            exit(14);
+        }
+    }
+    else if (0 == strncmp("rss:", arg, 4)) {
+        rss_mib = parse_count_(arg + 4, "RSS");
+    }
+    else if (0 == strncmp("prog:", arg, 5)) {
+        prog_path = arg + 5;
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [runs:<N>] [rss:<MiB>] [prog:<Path>]\n");
+    fprintf(out_stream, "  First dirties 'rss' MiB (default 1024; G suffix for GiB, 0 for none),\n"
+            "  then spawns 'prog' (default ./za-true1) N times (default 1000)\n"
+            "  with each method, waiting for each child to exit.\n");
+}
+
+
+static int
+clone_child_ (void *arg)
+{
+    char *const *const  child_argv = arg;
+
+    execv(child_argv[0], child_argv);
+
+    _exit(127);
+}
+
+/*
+ * Returns the pid of the child, or -1.
+ */
+static pid_t
+spawn_ (spawn_kind kind, char *const child_argv[], char *child_stack)
+{
+    pid_t  pid = -1;
+
+    errno_t  err;
+
+    switch (kind) {
+    case SPAWN_FORK:
+        pid = fork();
+        if (0 == pid) {
+            execv(child_argv[0], child_argv);
+            _exit(127);
+        }
+        break;
+    case SPAWN_VFORK:
+        /* The child may only call exec() or _exit(). */
+        pid = vfork();
+        if (0 == pid) {
+            execv(child_argv[0], child_argv);
+            _exit(127);
+        }
+        break;
+    case SPAWN_POSIX_SPAWN:
+        err = posix_spawn(&pid, child_argv[0], NULL, NULL, child_argv, environ);
+        if (err != 0) {
+            errno = err;
+            pid = -1;
+        }
+        break;
+    case SPAWN_CLONE_VM:
+        /* The stack grows down on all the architectures we care about. */
+        pid = clone(clone_child_, child_stack + CHILD_STACK_SIZE,
+                    CLONE_VM | CLONE_VFORK | SIGCHLD, (void *) child_argv);
+        break;
+    default:
+        errno = EINVAL;
+        break;
+    }
+
+    return pid;
+}
+
+static int
+run_kind_ (spawn_kind kind, char *child_stack)
+{
+    char *const  child_argv[] = { (char *) prog_path, NULL };
+
+    ulat_hist  lh;
+
+    unsigned long long  t_begin;
+    unsigned long long  t_total;
+
+    unsigned long  ix;
+    unsigned long  n_failed = 0;
+
+    pid_t  pid;
+
+    int  status;
+
+    ulat_hist_reset(&lh);
+
+    t_total = ulat_now_ns();
+    for (ix = 0; ix < runs; ++ix) {
+        t_begin = ulat_now_ns();
+
+        pid = spawn_(kind, child_argv, child_stack);
+        if (pid < 0) {
+            fprintf(stderr, "%s failed: errno %d = %s\n",
+                    Kind_Names[kind], errno, strerror(errno));
+            return 21;
+        }
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                perror("waitpid()");
+                return 22;
+            }
+        }
+        ulat_hist_add(&lh, ulat_now_ns() - t_begin);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ++n_failed;
+        }
+    }
+    t_total = ulat_now_ns() - t_total;
+
+    printf("%-22s %12.0f %10.1f %10.1f %10.1f%s\n", Kind_Names[kind],
+           (double) runs * 1e9 / (double) t_total,
+           (double) lh.lh_sum / (double) lh.lh_count / 1e3,
+           (double) ulat_hist_percentile(&lh, 50.0) / 1e3,
+           (double) ulat_hist_percentile(&lh, 99.0) / 1e3,
+           (n_failed > 0) ? "  (some children failed)" : "");
+
+    return 0;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    char *rss = NULL;
+    char *child_stack;
+
+    const size_t  page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    size_t  rss_len;
+    size_t  pos;
+
+    int  kind;
+    int  arg_pos;
+    int  res;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg_(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+
+    if (access(prog_path, X_OK) != 0) {
+        fprintf(stderr, "Cannot execute '%s': errno %d = %s\n",
+                prog_path, errno, strerror(errno));
+        return 3;
+    }
+
+    child_stack = malloc(CHILD_STACK_SIZE);
+    if (NULL == child_stack) {
+        perror("malloc(child stack)");
+        return 4;
+    }
+
+    rss_len = (size_t) rss_mib * 1024 * 1024;
+    if (rss_len > 0) {
+        rss = mmap(NULL, rss_len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == rss) {
+            perror("mmap(RSS)");
+            return 5;
+        }
+        for (pos = 0; pos < rss_len; pos += page_size) {
+            rss[pos] = 1;
+        }
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("Spawning '%s' %lu times per method, with %lu MiB dirty in the parent.\n",
+           prog_path, runs, rss_mib);
+    printf("%-22s %12s %10s %10s %10s\n", "method", "spawns/s",
+           "mean us", "p50 us", "p99 us");
+
+    for (kind = 0; kind < SPAWN_N_KINDS; ++kind) {
+        res = run_kind_((spawn_kind) kind, child_stack);
+        if (res != 0) {
+            return res;
+        }
+    }
+
+    if (rss != NULL) {
+        munmap(rss, rss_len);
+    }
+    free(child_stack);
+
+    return 0;
+}
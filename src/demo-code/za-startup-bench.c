@@ -0,0 +1,258 @@
+/*
+ * demo-code/za-startup-bench.c
+ *
+ * Process startup cost: fork(), exec() of a minimal program, its exit
+ * and the waitpid() that reaps it, timed together, thousands of times.
+ * By default for za-empty, za-true* and za-printf*, each one in all
+ * the builds found: dynamic (the usual ones), and from 'make startup-variants':
+ * static, static PIE, and dynamic with eager binding (-z now).
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define PROGRAMS_MAX  64
+
+static const char *const Default_Programs[] = {
+    "za-empty",
+    "za-true1", "za-true2", "za-true3", "za-true4", "za-true5",
+    "za-printf1", "za-printf2", "za-printf3", "za-printf4", "za-printf5", "za-printf6"
+};
+
+/* Suffixes of the builds, as named by the Makefile; "" = the usual one. */
+static const char *const Variant_Suffixes[] = {
+    "",
+    "-static",
+    "-static-pie",
+    "-now"
+};
+
+static const char *programs[PROGRAMS_MAX];
+static int          n_programs = 0;
+
+static const char *dir = ".";
+
+static unsigned long  runs = 2000;
+
+
+static unsigned long
+parse_count_ (const char *data)
+{
+    char *end = NULL;  /* for strto...() functions */
+
+    errno_t  strto_err;
+
+    unsigned long  value;
+
+    errno = 0;
+    value = strtoul(data, &end, 10);
+    strto_err = errno;
+
+    if (end == data) {
+        fprintf(stderr, "Could not parse count '%s'\n",
+                data);
+        exit(11);
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "Unexpected text '%s' after count %lu\n",
+                end, value);
+        exit(12);
+    }
+    if (strto_err != 0) {
+        fprintf(stderr, "Parsing count '%s' failed with errno %d: %s\n",
+                data, strto_err, strerror(strto_err));
+        exit(13);
+    }
+    if (0 == value) {
+        fprintf(stderr, "The count must be above 0.\n");
+        exit(14);
+    }
+
+    return value;
+}
+
+/*
+ * Handle Argument (usually coming from command-line interface).
+ * This function handles one argument, but it can be any of the legal arguments.
+ * Intended to be called repeatedly until command-line arguments are exhausted.
+ * Arguments without a colon are program names (replacing the default list).
+ */
+static int
+handle_arg_ (const char *arg)
+{
+    if (0 == strncmp("runs:", arg, 5)) {
+        runs = parse_count_(arg + 5);
+    }
+    else if (0 == strncmp("dir:", arg, 4)) {
+        dir = arg + 4;
+    }
+    else if (strchr(arg, ':') == NULL && n_programs < PROGRAMS_MAX) {
+        programs[n_programs++] = arg;
+    }
+    else {
+        return -1;  /* unknown argument */
+    }
+
+    return 0;
+}
+
+static void
+show_usage (FILE *out_stream)
+{
+    fprintf(out_stream, "Usage: [runs:<N>] [dir:<Path>] [<Program>...]\n");
+    fprintf(out_stream, "  Runs each program (default: za-empty, za-true*, za-printf*) N times\n"
+            "  (default 2000) from 'dir' (default .), in each build that exists there:\n"
+            "  <Program>, <Program>-static, -static-pie and -now"
+            " (see 'make startup-variants').\n"
+            "  Standard output of the programs goes to /dev/null.\n");
+}
+
+
+/*
+ * Returns the number of runs that did not exit with status 0,
+ * or -1 if fork() failed.
+ */
+static long
+run_program_ (const char *path, int null_fd, ulat_hist *lh)
+{
+    char *const  child_argv[] = { (char *) path, NULL };
+
+    unsigned long long  t_begin;
+
+    unsigned long  ix;
+
+    long  n_failed = 0;
+
+    pid_t  pid;
+
+    int  status;
+
+    for (ix = 0; ix < runs; ++ix) {
+        t_begin = ulat_now_ns();
+
+        pid = fork();
+        if (pid < 0) {
+            perror("fork()");
+            return -1;
+        }
+        if (0 == pid) {
+            dup2(null_fd, STDOUT_FILENO);
+            execv(path, child_argv);
+            _exit(127);
+        }
+
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                perror("waitpid()");
+                return -1;
+            }
+        }
+        ulat_hist_add(lh, ulat_now_ns() - t_begin);
+
+        /* za-empty and friends may exit with any status: only exec() counts */
+        if (!WIFEXITED(status) || 127 == WEXITSTATUS(status)) {
+            ++n_failed;
+        }
+    }
+
+    return n_failed;
+}
+
+
+int
+main (int argc, char* argv[])
+{
+    char  path[4096];
+
+    ulat_hist  lh;
+
+    long  n_failed;
+
+    size_t  var_ix;
+
+    int  null_fd;
+    int  prog_ix;
+    int  arg_pos;
+    int  res;
+
+    for (arg_pos = 1; arg_pos < argc; ++arg_pos) {
+        res = handle_arg_(argv[arg_pos]);
+        if (res != 0) {
+            fprintf(stderr, "Unrecognized argument '%s'.\n",
+                    argv[arg_pos]);
+            show_usage(stderr);
+            return 2;
+        }
+    }
+    if (0 == n_programs) {
+        for (prog_ix = 0; prog_ix < (int) (sizeof Default_Programs / sizeof Default_Programs[0]);
+             ++prog_ix) {
+            programs[n_programs++] = Default_Programs[prog_ix];
+        }
+    }
+
+    null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (null_fd < 0) {
+        perror("open(/dev/null)");
+        return 3;
+    }
+
+    printf("Pid = %ld\n", (long) getpid());
+    printf("fork() + exec() + exit + waitpid(), %lu runs each, in microseconds.\n", runs);
+    printf("%-24s %10s %10s %10s %10s\n", "program", "mean", "p50", "p99", "max");
+
+    for (prog_ix = 0; prog_ix < n_programs; ++prog_ix) {
+        for (var_ix = 0; var_ix < sizeof Variant_Suffixes / sizeof Variant_Suffixes[0];
+             ++var_ix) {
+            snprintf(path, sizeof path, "%s/%s%s", dir, programs[prog_ix],
+                     Variant_Suffixes[var_ix]);
+            if (access(path, X_OK) != 0) {
+                continue;  /* not built */
+            }
+
+            ulat_hist_reset(&lh);
+            n_failed = run_program_(path, null_fd, &lh);
+            if (n_failed < 0) {
+                return 4;
+            }
+
+            printf("%-24s %10.1f %10.1f %10.1f %10.1f%s\n",
+                   path + strlen(dir) + 1,
+                   (double) lh.lh_sum / (double) lh.lh_count / 1e3,
+                   (double) ulat_hist_percentile(&lh, 50.0) / 1e3,
+                   (double) ulat_hist_percentile(&lh, 99.0) / 1e3,
+                   (double) lh.lh_max / 1e3,
+                   (n_failed > 0) ? "  (exec failed)" : "");
+        }
+    }
+
+    return 0;
+}
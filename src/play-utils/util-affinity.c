@@ -0,0 +1,89 @@
+/*
+ * play-utils/util-affinity.c
+ *
+ * Utility module for CPU affinity of threads (Linux/GNU specific;
+ * the rest of play-utils only needs POSIX).
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _GNU_SOURCE  /* for cpu_set_t, CPU_SET(), pthread_setaffinity_np() */
+#include "util-affinity.h"
+
+#include <errno.h>
+#include <limits.h>  /* for 'INT_MAX', etc. */
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+
+static int
+parse_cpu_number_ (const char *data, const char **end_out)
+{
+    char *end = NULL;  /* for strto...() functions */
+    long  cpu;
+
+    errno = 0;
+    cpu = strtol(data, &end, 10);
+
+    if (end == data || errno != 0 || cpu < 0 || cpu >= CPU_SETSIZE) {
+        return -1;
+    }
+
+    *end_out = end;
+    return (int) cpu;
+}
+
+int
+uaff_parse_cpu_range (const char *spec, int *first_cpu, int *last_cpu)
+{
+    const char *curr = spec;
+    int  first;
+    int  last;
+
+    first = parse_cpu_number_(curr, &curr);
+    if (first < 0) {
+        return -1;
+    }
+
+    if ('\0' == *curr) {
+        last = first;
+    } else if ('-' == *curr) {
+        last = parse_cpu_number_(curr + 1, &curr);
+        if (last < 0) {
+            return -2;
+        }
+        if ('\0' != *curr) {
+            return -3;
+        }
+        if (last < first) {
+            return -4;
+        }
+    } else {
+        return -5;
+    }
+
+    *first_cpu = first;
+    *last_cpu = last;
+    return 0;
+}
+
+int
+uaff_pin_current_thread (int first_cpu, int last_cpu)
+{
+    cpu_set_t  cpus;
+    int  cpu;
+
+    CPU_ZERO(&cpus);
+    for (cpu = first_cpu; cpu <= last_cpu; ++cpu) {
+        CPU_SET(cpu, &cpus);
+    }
+
+    /* Returns an errno value, like the other pthread functions: */
+    return pthread_setaffinity_np(pthread_self(), sizeof cpus, &cpus);
+}
@@ -0,0 +1,27 @@
+/*
+ * play-utils/util-affinity.h
+ *
+ * Utility module for CPU affinity of threads (Linux/GNU specific;
+ * the rest of play-utils only needs POSIX).
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+
+/*
+ * Parse a CPU spec: "N" for a single CPU, or "N-M" for
+ * an inclusive range of CPUs.
+ * Returns zero for success, a negative value for bad syntax or range.
+ */
+int  uaff_parse_cpu_range(const char *spec, int *first_cpu, int *last_cpu);
+
+/*
+ * Restrict the calling thread to the CPUs 'first_cpu' ... 'last_cpu'.
+ * Returns zero for success, or an errno value.
+ */
+int  uaff_pin_current_thread(int first_cpu, int last_cpu);
@@ -0,0 +1,120 @@
+/*
+ * play-utils/util-arena.c
+ *
+ * Utility module for an arena (bump) allocator: one large reservation
+ * (see util-mem-range.h), committed in UAR_COMMIT_UNIT steps as it fills up;
+ * single allocations are never freed, the whole arena is reset at once.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "util-arena.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+
+int
+uar_init (uar_arena *ar, size_t capacity, size_t guard_len)
+{
+    int  err;
+
+    memset(ar, 0, sizeof *ar);
+
+    capacity = umr_round_up(capacity, UAR_COMMIT_UNIT);
+    ar->ar_guard_len = umr_round_up(guard_len, umr_page_size());
+
+    err = umr_reserve(&ar->ar_reserved, capacity + ar->ar_guard_len);
+    if (err != 0) {
+        return err;
+    }
+
+    ar->ar_next = ar->ar_reserved.m_base_addr;
+    ar->ar_committed_end = ar->ar_next;
+    ar->ar_limit = ar->ar_next + capacity;
+
+    return 0;
+}
+
+void *
+uar_alloc_slow (uar_arena *ar, size_t size, size_t align)
+{
+    umr_range  more;
+
+    char *const p = (char *) (((uintptr_t) ar->ar_next + align - 1)
+                              & ~(uintptr_t) (align - 1));
+
+    char *new_end;
+
+    if (p > ar->ar_limit || size > (size_t) (ar->ar_limit - p)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    new_end = (char *) ar->ar_reserved.m_base_addr
+              + umr_round_up((size_t) (p + size - (char *) ar->ar_reserved.m_base_addr),
+                             UAR_COMMIT_UNIT);
+
+    umr_subrange(&more, &ar->ar_reserved,
+                 (size_t) (ar->ar_committed_end - (char *) ar->ar_reserved.m_base_addr),
+                 (size_t) (new_end - ar->ar_committed_end));
+    if (umr_protect(&more, PROT_READ | PROT_WRITE) != 0) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    ++ar->ar_n_commits;
+    ar->ar_committed_end = new_end;
+
+    ar->ar_next = p + size;
+
+    return p;
+}
+
+void
+uar_reset (uar_arena *ar, int discard)
+{
+    umr_range  committed;
+
+    const size_t  used = (size_t) (ar->ar_next - (char *) ar->ar_reserved.m_base_addr);
+
+    if (used > ar->ar_peak_used) {
+        ar->ar_peak_used = used;
+    }
+
+    if (discard && ar->ar_committed_end > (char *) ar->ar_reserved.m_base_addr) {
+        umr_subrange(&committed, &ar->ar_reserved, 0,
+                     (size_t) (ar->ar_committed_end - (char *) ar->ar_reserved.m_base_addr));
+        (void) umr_discard(&committed);  /* reported; the arena is still usable */
+    }
+
+    ar->ar_next = ar->ar_reserved.m_base_addr;
+    ++ar->ar_n_resets;
+}
+
+void
+uar_destroy (uar_arena *ar)
+{
+    if (ar->ar_reserved.m_base_addr != NULL) {
+        (void) umr_release(&ar->ar_reserved);
+    }
+    memset(ar, 0, sizeof *ar);
+}
+
+void
+uar_show_stats (const uar_arena *ar, const char *preamble, FILE *out_stream)
+{
+    const char *const  base = ar->ar_reserved.m_base_addr;
+
+    fprintf(out_stream, "%s Arena of %zu KiB (+ %zu KiB guard): %zu KiB committed"
+            " in %lu steps, %zu KiB used now, peak %zu KiB; %lu resets.\n",
+            preamble, (size_t) (ar->ar_limit - base) / 1024, ar->ar_guard_len / 1024,
+            (size_t) (ar->ar_committed_end - base) / 1024, ar->ar_n_commits,
+            (size_t) (ar->ar_next - base) / 1024, ar->ar_peak_used / 1024,
+            ar->ar_n_resets);
+}
@@ -0,0 +1,100 @@
+/*
+ * play-utils/util-arena.h
+ *
+ * Utility module for an arena (bump) allocator: one large reservation
+ * (see util-mem-range.h), committed in UAR_COMMIT_UNIT steps as it fills up;
+ * single allocations are never freed, the whole arena is reset at once.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#ifndef UTIL_ARENA_H
+#define UTIL_ARENA_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "util-mem-range.h"
+
+
+/*
+ * Same as 'Mem_Map_Unit' in za-mmap-split-merge.c: one mprotect() per
+ * 64 KBytes.  The committed part stays a single VMA, since each step
+ * extends it with the same protection.
+ */
+#define UAR_COMMIT_UNIT  (64 * 1024)
+
+/* as malloc() */
+#define UAR_DEFAULT_ALIGN  16
+
+
+typedef struct {
+    char *ar_next;           /* first free byte */
+    char *ar_committed_end;  /* readable and writable up to here */
+    char *ar_limit;          /* end of the usable part; the guard follows */
+
+    umr_range  ar_reserved;  /* usable part + guard */
+    size_t     ar_guard_len;
+
+    unsigned long  ar_n_commits;  /* mprotect() calls */
+    unsigned long  ar_n_resets;
+    size_t         ar_peak_used;  /* highest use before a reset */
+} uar_arena;
+
+
+/*
+ * Reserves 'capacity' bytes, plus 'guard_len' bytes (rounded up
+ * to whole pages; may be 0) that are never made accessible:
+ * running past the end of a full arena faults instead of writing
+ * into whatever happens to be mapped next.  Nothing is committed yet.
+ * Returns 0, or an errno value.
+ */
+int  uar_init(uar_arena *ar, size_t capacity, size_t guard_len);
+
+/*
+ * Commits more, then allocates: for uar_alloc_aligned() only.
+ * Returns NULL with 'errno' = ENOMEM if the arena is full.
+ */
+void *  uar_alloc_slow(uar_arena *ar, size_t size, size_t align);
+
+/*
+ * 'align' must be a power of two.  The fast path is a few instructions,
+ * hence inline; no locks: an arena belongs to one thread at a time.
+ */
+static inline void *
+uar_alloc_aligned (uar_arena *ar, size_t size, size_t align)
+{
+    char *const p = (char *) (((uintptr_t) ar->ar_next + align - 1)
+                              & ~(uintptr_t) (align - 1));
+
+    if (p <= ar->ar_committed_end && size <= (size_t) (ar->ar_committed_end - p)) {
+        ar->ar_next = p + size;
+        return p;
+    }
+
+    return uar_alloc_slow(ar, size, align);
+}
+
+static inline void *
+uar_alloc (uar_arena *ar, size_t size)
+{
+    return uar_alloc_aligned(ar, size, UAR_DEFAULT_ALIGN);
+}
+
+/*
+ * Frees all the allocations at once, in O(1): the committed part is kept.
+ * With 'discard', its pages are also given back (MADV_DONTNEED, a single
+ * call however large the arena), and will fault in again, zeroed, when used.
+ */
+void  uar_reset(uar_arena *ar, int discard);
+
+void  uar_destroy(uar_arena *ar);
+
+void  uar_show_stats(const uar_arena *ar, const char *preamble, FILE *out_stream);
+
+#endif  /* UTIL_ARENA_H */
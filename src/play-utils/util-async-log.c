@@ -0,0 +1,789 @@
+/*
+ * play-utils/util-async-log.c
+ *
+ * Utility module for asynchronous logging: printf-like calls store
+ * binary records (the format pointer and the raw arguments) in
+ * a per-thread ring, and a background thread formats them and
+ * writes them out in batches, with writev().
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "util-async-log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdalign.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include "util-latency.h"
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define RING_MASK  (UALOG_RING_SIZE - 1)
+
+/* Longest conversion specification we copy, '%' and conversion included. */
+#define SPEC_LEN_MAX  32
+
+/* Longest formatted record; the rest is cut. */
+#define LINE_MAX_  1024
+
+#define OUT_BUF_SIZE  (64 * 1024)
+#define IOV_MAX_  64
+
+
+typedef union {
+    long long           a_ll;
+    unsigned long long  a_ull;
+    double              a_dbl;
+    const void         *a_ptr;
+    size_t              a_off;  /* '%s': offset of the copy in 'lr_text' */
+} record_arg_;
+
+typedef struct {
+    unsigned long long  lr_ns;  /* when queued */
+
+    const char  *lr_format;  /* NULL: 'lr_text' holds the formatted record */
+    int  lr_fd;
+    int  lr_n_args;
+
+    record_arg_  lr_args[UALOG_ARGS_MAX];
+
+    char  lr_text[UALOG_TEXT_MAX];
+} record_;
+
+/*
+ * Single producer (the owner thread), single consumer (the writer).
+ * The counters only grow; an index is the counter masked.
+ */
+typedef struct ring_ {
+    alignas(64) _Atomic unsigned long  rg_head;  /* next record to fill */
+    _Atomic unsigned long  rg_dropped;
+    _Atomic int  rg_busy;  /* the owner is inside ualog_printf(), see ualog_stop() */
+    _Atomic int  rg_owned;  /* 0: the owner exited, another thread may take it */
+
+    alignas(64) _Atomic unsigned long  rg_tail;  /* next record to write */
+    unsigned long  rg_formatted;  /* writer only: ahead of the tail until written */
+
+    struct ring_  *rg_next;  /* immutable once published */
+
+    record_  rg_records[UALOG_RING_SIZE];
+} ring_;
+
+
+_Atomic int  ualog_started_ = 0;
+
+static _Thread_local ring_ *my_ring = NULL;
+
+/*
+ * New rings are pushed at the head, under the mutex; the writer only
+ * loads the head and walks the (immutable) links, without the mutex.
+ * Rings are never freed: the destructor of the key gives the ring of
+ * an exiting thread back, for the next thread that starts logging.
+ */
+static pthread_mutex_t  rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(ring_ *)  rings_head = NULL;
+
+static pthread_once_t  ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   ring_key;
+static int  ring_key_ok = 0;
+
+static pthread_t  writer_tid;
+static _Atomic int  stop_requested = 0;
+
+/* Updated only by the writer thread, shown after it is joined. */
+static unsigned long long  num_written = 0;
+static unsigned long long  num_writev = 0;
+static unsigned long long  num_write_errors = 0;
+static ulat_hist  delay_hist;
+
+
+/*
+ * Conversion specifications
+ * -------------------------
+ */
+
+typedef struct {
+    size_t  sp_len;   /* from '%' to the conversion character, inclusive */
+    char    sp_conv;
+    char    sp_size;  /* 0, 'H' = "hh", 'h', 'l', 'q' = "ll", 'j', 'z', 't' */
+} spec_;
+
+/*
+ * 'p' points at a '%'.  Returns 0, or -1 for what we do not support
+ * ('*' widths, 'long double', '%n', '%ls', '%m', ...).
+ */
+static int
+parse_spec_ (const char *p, spec_ *sp)
+{
+    const char *q = p + 1;
+
+    sp->sp_size = 0;
+
+    while (*q != '\0' && strchr("-+ #0'", *q) != NULL) {
+        ++q;
+    }
+    while (*q >= '0' && *q <= '9') {
+        ++q;
+    }
+    if ('.' == *q) {
+        ++q;
+        while (*q >= '0' && *q <= '9') {
+            ++q;
+        }
+    }
+
+    switch (*q) {
+    case 'h':
+        ++q;
+        if ('h' == *q) {
+            ++q;
+            sp->sp_size = 'H';
+        } else {
+            sp->sp_size = 'h';
+        }
+        break;
+    case 'l':
+        ++q;
+        if ('l' == *q) {
+            ++q;
+            sp->sp_size = 'q';
+        } else {
+            sp->sp_size = 'l';
+        }
+        break;
+    case 'j':
+    case 'z':
+    case 't':
+        sp->sp_size = *q++;
+        break;
+    default:
+        break;
+    }
+
+    if ('\0' == *q || strchr("diouxXcsfFeEgGaAp%", *q) == NULL) {
+        return -1;
+    }
+    sp->sp_conv = *q;
+    sp->sp_len = (size_t) (q - p) + 1;
+
+    if (sp->sp_len >= SPEC_LEN_MAX) {
+        return -1;
+    }
+    if (('c' == sp->sp_conv || 's' == sp->sp_conv || 'p' == sp->sp_conv)
+        && sp->sp_size != 0) {
+        return -1;  /* wide characters, or nonsense */
+    }
+    return 0;
+}
+
+static long long
+arg_signed_ (char size, va_list *ap)
+{
+    switch (size) {
+    case 'l':  return va_arg(*ap, long);
+    case 'q':  return va_arg(*ap, long long);
+    case 'j':  return va_arg(*ap, intmax_t);
+    case 'z':  return va_arg(*ap, ssize_t);
+    case 't':  return va_arg(*ap, ptrdiff_t);
+    default:   return va_arg(*ap, int);  /* promoted */
+    }
+}
+
+static unsigned long long
+arg_unsigned_ (char size, va_list *ap)
+{
+    switch (size) {
+    case 'l':  return va_arg(*ap, unsigned long);
+    case 'q':  return va_arg(*ap, unsigned long long);
+    case 'j':  return va_arg(*ap, uintmax_t);
+    case 'z':  return va_arg(*ap, size_t);
+    case 't':  return (unsigned long long) va_arg(*ap, ptrdiff_t);
+    default:   return va_arg(*ap, unsigned int);  /* promoted */
+    }
+}
+
+/*
+ * Stores the arguments of one call in 'rec'.
+ * Returns -1 if the record cannot hold them.
+ */
+static int
+capture_args_ (record_ *rec, const char *format, va_list *ap)
+{
+    const char *p = format;
+    spec_  sp;
+
+    size_t  text_used = 0;
+    size_t  str_len;
+    const char *str;
+
+    rec->lr_n_args = 0;
+
+    while ((p = strchr(p, '%')) != NULL) {
+        if (parse_spec_(p, &sp) < 0) {
+            return -1;
+        }
+        p += sp.sp_len;
+        if ('%' == sp.sp_conv) {
+            continue;
+        }
+        if (UALOG_ARGS_MAX == rec->lr_n_args) {
+            return -1;
+        }
+
+        switch (sp.sp_conv) {
+        case 'd':  case 'i':  case 'c':
+            rec->lr_args[rec->lr_n_args].a_ll = arg_signed_(sp.sp_size, ap);
+            break;
+        case 'o':  case 'u':  case 'x':  case 'X':
+            rec->lr_args[rec->lr_n_args].a_ull = arg_unsigned_(sp.sp_size, ap);
+            break;
+        case 'p':
+            rec->lr_args[rec->lr_n_args].a_ptr = va_arg(*ap, void *);
+            break;
+        case 's':
+            str = va_arg(*ap, const char *);
+            if (NULL == str) {
+                str = "(null)";
+            }
+            str_len = strlen(str);
+            if (text_used + str_len + 1 > sizeof rec->lr_text) {
+                return -1;
+            }
+            memcpy(rec->lr_text + text_used, str, str_len + 1);
+            rec->lr_args[rec->lr_n_args].a_off = text_used;
+            text_used += str_len + 1;
+            break;
+        default:  /* floating point */
+            rec->lr_args[rec->lr_n_args].a_dbl = va_arg(*ap, double);
+            break;
+        }
+        ++rec->lr_n_args;
+    }
+    return 0;
+}
+
+/*
+ * Formats 'rec' into 'out' (of 'size' bytes, at least 1).
+ * Returns the length, cut to 'size - 1'.
+ */
+static size_t
+format_record_ (const record_ *rec, char *out, size_t size)
+{
+    const char *p = rec->lr_format;
+    const char *pct;
+    const record_arg_ *arg = rec->lr_args;
+
+    char    spec_buf[SPEC_LEN_MAX];
+    spec_   sp;
+    size_t  used = 0;
+    size_t  seg;
+    int     n;
+
+    if (NULL == p) {  /* formatted by the producer */
+        used = strnlen(rec->lr_text, size - 1);
+        memcpy(out, rec->lr_text, used);
+        out[used] = '\0';
+        return used;
+    }
+
+    while (*p != '\0' && used < size - 1) {
+        pct = strchr(p, '%');
+        seg = (NULL == pct) ? strlen(p) : (size_t) (pct - p);
+        if (seg > size - 1 - used) {
+            seg = size - 1 - used;
+        }
+        memcpy(out + used, p, seg);
+        used += seg;
+        if (NULL == pct || used == size - 1) {
+            break;
+        }
+
+        (void) parse_spec_(pct, &sp);  /* already checked by capture_args_() */
+        p = pct + sp.sp_len;
+
+        if ('%' == sp.sp_conv) {
+            out[used++] = '%';
+            continue;
+        }
+        memcpy(spec_buf, pct, sp.sp_len);
+        spec_buf[sp.sp_len] = '\0';
+
+        switch (sp.sp_conv) {
+        case 'd':  case 'i':  case 'c':
+            switch (sp.sp_size) {
+            case 'l':  n = snprintf(out + used, size - used, spec_buf, (long) arg->a_ll);  break;
+            case 'q':  n = snprintf(out + used, size - used, spec_buf, arg->a_ll);  break;
+            case 'j':  n = snprintf(out + used, size - used, spec_buf, (intmax_t) arg->a_ll);  break;
+            case 'z':  n = snprintf(out + used, size - used, spec_buf, (ssize_t) arg->a_ll);  break;
+            case 't':  n = snprintf(out + used, size - used, spec_buf, (ptrdiff_t) arg->a_ll);  break;
+            default:   n = snprintf(out + used, size - used, spec_buf, (int) arg->a_ll);  break;
+            }
+            break;
+        case 'o':  case 'u':  case 'x':  case 'X':
+            switch (sp.sp_size) {
+            case 'l':  n = snprintf(out + used, size - used, spec_buf, (unsigned long) arg->a_ull);  break;
+            case 'q':  n = snprintf(out + used, size - used, spec_buf, arg->a_ull);  break;
+            case 'j':  n = snprintf(out + used, size - used, spec_buf, (uintmax_t) arg->a_ull);  break;
+            case 'z':  n = snprintf(out + used, size - used, spec_buf, (size_t) arg->a_ull);  break;
+            case 't':  n = snprintf(out + used, size - used, spec_buf, (ptrdiff_t) arg->a_ull);  break;
+            default:   n = snprintf(out + used, size - used, spec_buf, (unsigned int) arg->a_ull);  break;
+            }
+            break;
+        case 'p':
+            n = snprintf(out + used, size - used, spec_buf, arg->a_ptr);
+            break;
+        case 's':
+            n = snprintf(out + used, size - used, spec_buf, rec->lr_text + arg->a_off);
+            break;
+        default:
+            n = snprintf(out + used, size - used, spec_buf, arg->a_dbl);
+            break;
+        }
+        ++arg;
+
+        if (n < 0) {
+            break;
+        }
+        used += ((size_t) n < size - used) ? (size_t) n : size - 1 - used;
+    }
+
+    out[used] = '\0';
+    return used;
+}
+
+
+/*
+ * Producers
+ * ---------
+ */
+
+static void
+release_ring_ (void *arg)
+{
+    ring_ *ring = arg;
+
+    my_ring = NULL;
+    atomic_store_explicit(&ring->rg_owned, 0, memory_order_release);
+}
+
+static void
+create_ring_key_ (void)
+{
+    ring_key_ok = (0 == pthread_key_create(&ring_key, &release_ring_));
+}
+
+static ring_ *
+register_ring_ (void)
+{
+    ring_ *ring;
+    int  not_owned;
+
+    pthread_once(&ring_key_once, &create_ring_key_);
+
+    /*
+     * A ring given back may still hold records of its previous owner:
+     * the writer keeps going from its tail, so they are not lost.
+     */
+    for (ring = atomic_load_explicit(&rings_head, memory_order_acquire);
+         ring != NULL; ring = ring->rg_next) {
+        not_owned = 0;
+        if (atomic_compare_exchange_strong_explicit(&ring->rg_owned, &not_owned, 1,
+                                                    memory_order_acquire,
+                                                    memory_order_relaxed)) {
+            goto claimed;
+        }
+    }
+
+    /* malloc() only aligns for the basic types: not enough for 'alignas(64)'. */
+    if (posix_memalign((void **) &ring, alignof(ring_), sizeof *ring) != 0) {
+        return NULL;
+    }
+    atomic_init(&ring->rg_head, 0);
+    atomic_init(&ring->rg_dropped, 0);
+    atomic_init(&ring->rg_busy, 0);
+    atomic_init(&ring->rg_owned, 1);
+    atomic_init(&ring->rg_tail, 0);
+    ring->rg_formatted = 0;
+
+    pthread_mutex_lock(&rings_mutex);
+    ring->rg_next = atomic_load_explicit(&rings_head, memory_order_relaxed);
+    atomic_store_explicit(&rings_head, ring, memory_order_release);
+    pthread_mutex_unlock(&rings_mutex);
+
+claimed:
+    if (ring_key_ok) {
+        pthread_setspecific(ring_key, ring);
+    }
+    my_ring = ring;
+    return ring;
+}
+
+int
+ualog_printf (int fd, const char *format, ...)
+{
+    ring_ *ring = my_ring;
+    record_ *rec;
+    unsigned long  head;
+
+    va_list  ap;
+    va_list  ap_copy;
+    int      res;
+    int      old_cancel_state;
+
+    /*
+     * Not cancelled in the middle (asynchronous cancellation): a thread
+     * gone with 'rg_busy' set, or with the mutex held, would hang
+     * ualog_stop() and the other threads.
+     */
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
+
+    if (!ualog_enabled()) {
+        goto write_now;
+    }
+    if (NULL == ring) {
+        ring = register_ring_();
+        if (NULL == ring) {
+            goto write_now;
+        }
+    }
+
+    /*
+     * Flag first, then check again (both sequentially consistent):
+     * either ualog_stop() sees the flag and waits for the record,
+     * or we see the writer stopped and write the record ourselves.
+     */
+    atomic_store(&ring->rg_busy, 1);
+    if (!atomic_load(&ualog_started_)) {
+        atomic_store_explicit(&ring->rg_busy, 0, memory_order_release);
+        goto write_now;
+    }
+
+    head = atomic_load_explicit(&ring->rg_head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->rg_tail, memory_order_acquire)
+        >= UALOG_RING_SIZE) {
+        atomic_store_explicit(&ring->rg_dropped,
+                              atomic_load_explicit(&ring->rg_dropped,
+                                                   memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        atomic_store_explicit(&ring->rg_busy, 0, memory_order_release);
+        res = -1;
+        goto done;
+    }
+
+    rec = &ring->rg_records[head & RING_MASK];
+    rec->lr_ns = ulat_now_ns();
+    rec->lr_fd = fd;
+    rec->lr_format = format;
+
+    va_start(ap, format);
+    va_copy(ap_copy, ap);
+    res = capture_args_(rec, format, &ap);
+    if (res < 0) {
+        rec->lr_format = NULL;
+        vsnprintf(rec->lr_text, sizeof rec->lr_text, format, ap_copy);
+    }
+    va_end(ap_copy);
+    va_end(ap);
+
+    atomic_store_explicit(&ring->rg_head, head + 1, memory_order_release);
+    atomic_store_explicit(&ring->rg_busy, 0, memory_order_release);
+    res = 0;
+    goto done;
+
+write_now:
+    va_start(ap, format);
+    res = (vdprintf(fd, format, ap) < 0) ? -1 : 0;
+    va_end(ap);
+
+done:
+    pthread_setcancelstate(old_cancel_state, NULL);
+    return res;
+}
+
+
+/*
+ * Writer thread
+ * -------------
+ */
+
+static char  out_buf[OUT_BUF_SIZE];
+static size_t  out_used = 0;
+
+static struct iovec  out_iov[IOV_MAX_];
+static unsigned long long  out_iov_ns[IOV_MAX_];
+static int  out_n_iov = 0;
+static int  out_fd = -1;
+
+static void
+write_batch_ (void)
+{
+    struct iovec *iov = out_iov;
+    int  n_iov = out_n_iov;
+
+    unsigned long long  now_ns;
+    ssize_t  num_written_now;
+    size_t   left;
+    int  ix;
+
+    while (n_iov > 0) {
+        num_written_now = writev(out_fd, iov, n_iov);
+        ++num_writev;
+        if (num_written_now < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            ++num_write_errors;  /* nowhere to report it: drop the batch */
+            break;
+        }
+
+        /* Short write (a full pipe): skip what went out, retry the rest. */
+        left = (size_t) num_written_now;
+        while (n_iov > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --n_iov;
+        }
+        if (n_iov > 0) {
+            iov->iov_base = (char *) iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    now_ns = ulat_now_ns();
+    for (ix = 0; ix < out_n_iov; ++ix) {
+        ulat_hist_add(&delay_hist, now_ns - out_iov_ns[ix]);
+    }
+    num_written += (unsigned long long) out_n_iov;
+
+    out_used = 0;
+    out_n_iov = 0;
+}
+
+static void
+add_record_ (const record_ *rec)
+{
+    size_t  len;
+
+    if (out_n_iov > 0
+        && (rec->lr_fd != out_fd || IOV_MAX_ == out_n_iov
+            || OUT_BUF_SIZE - out_used < LINE_MAX_)) {
+        write_batch_();
+    }
+
+    len = format_record_(rec, out_buf + out_used, LINE_MAX_);
+
+    out_fd = rec->lr_fd;
+    out_iov[out_n_iov].iov_base = out_buf + out_used;
+    out_iov[out_n_iov].iov_len = len;
+    out_iov_ns[out_n_iov] = rec->lr_ns;
+    ++out_n_iov;
+    out_used += len;
+}
+
+/*
+ * One pass over all the rings.  The tails move only after the batch
+ * is written, so the records stay in place for ualog_flush() to wait on,
+ * and a producer never reuses a record the writer is still formatting.
+ * Returns the number of records found.
+ */
+static unsigned long
+drain_rings_ (void)
+{
+    ring_ *const first = atomic_load_explicit(&rings_head, memory_order_acquire);
+    ring_ *ring;
+
+    unsigned long  head;
+    unsigned long  found = 0;
+
+    for (ring = first; ring != NULL; ring = ring->rg_next) {
+        head = atomic_load_explicit(&ring->rg_head, memory_order_acquire);
+        for (; ring->rg_formatted != head; ++ring->rg_formatted) {
+            add_record_(&ring->rg_records[ring->rg_formatted & RING_MASK]);
+            ++found;
+        }
+    }
+    if (0 == found) {
+        return 0;
+    }
+
+    write_batch_();
+
+    for (ring = first; ring != NULL; ring = ring->rg_next) {
+        atomic_store_explicit(&ring->rg_tail, ring->rg_formatted,
+                              memory_order_release);
+    }
+    return found;
+}
+
+static void *
+writer_thread_func_ (void *arg)
+{
+    const struct timespec  idle = { 0, UALOG_IDLE_SLEEP_NS };
+
+    (void) arg;
+
+    while (!atomic_load_explicit(&stop_requested, memory_order_acquire)) {
+        if (0 == drain_rings_()) {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    /* Final passes; ualog_stop() writes what comes after. */
+    while (drain_rings_() > 0) {
+    }
+    return NULL;
+}
+
+
+/*
+ * Control
+ * -------
+ */
+
+int
+ualog_start (void)
+{
+    sigset_t  all_sigs;
+    sigset_t  saved_sigs;
+    errno_t   res;
+
+    if (ualog_enabled()) {
+        return EALREADY;
+    }
+
+    fflush(NULL);
+
+    ulat_hist_reset(&delay_hist);
+    num_written = 0;
+    num_writev = 0;
+    num_write_errors = 0;
+    atomic_store_explicit(&stop_requested, 0, memory_order_relaxed);
+
+    /*
+     * The writer inherits a full signal mask: the signals of the demos
+     * must keep going to the threads that wait for them (or handle them).
+     */
+    sigfillset(&all_sigs);
+    pthread_sigmask(SIG_SETMASK, &all_sigs, &saved_sigs);
+    res = pthread_create(&writer_tid, NULL, &writer_thread_func_, NULL);
+    pthread_sigmask(SIG_SETMASK, &saved_sigs, NULL);
+
+    if (res != 0) {
+        return res;
+    }
+
+    atomic_store_explicit(&ualog_started_, 1, memory_order_release);
+    return 0;
+}
+
+void
+ualog_flush (void)
+{
+    const struct timespec  pause = { 0, UALOG_IDLE_SLEEP_NS / 10 };
+    ring_ *ring;
+    unsigned long  head;
+
+    if (!ualog_enabled()) {
+        return;
+    }
+
+    for (ring = atomic_load_explicit(&rings_head, memory_order_acquire);
+         ring != NULL; ring = ring->rg_next) {
+        head = atomic_load_explicit(&ring->rg_head, memory_order_acquire);
+        /* signed difference: the counters may wrap around */
+        while ((long) (atomic_load_explicit(&ring->rg_tail, memory_order_acquire)
+                       - head) < 0) {
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+}
+
+void
+ualog_stop (FILE *report_stream)
+{
+    const struct timespec  pause = { 0, UALOG_IDLE_SLEEP_NS / 10 };
+    ring_ *ring;
+    ring_ *next;
+
+    unsigned long long  num_dropped = 0;
+    errno_t  res;
+
+    if (!ualog_enabled()) {
+        return;
+    }
+
+    atomic_store_explicit(&stop_requested, 1, memory_order_release);
+
+    res = pthread_join(writer_tid, NULL);
+
+    /*
+     * Producers keep queueing until they see the flag cleared, then
+     * write directly.  One already past its check still owns a record:
+     * wait for it (see 'rg_busy'), then write the leftovers ourselves.
+     */
+    atomic_store(&ualog_started_, 0);
+    if (res != 0) {
+        fprintf(stderr, "pthread_join(async log writer) failed, returning the errno value %d = %s\n",
+                res, strerror(res));
+        return;
+    }
+
+    for (ring = atomic_load_explicit(&rings_head, memory_order_acquire);
+         ring != NULL; ring = ring->rg_next) {
+        while (atomic_load(&ring->rg_busy)) {
+            nanosleep(&pause, NULL);
+        }
+    }
+    while (drain_rings_() > 0) {
+    }
+
+    /* The rings stay allocated: other threads keep pointers to theirs. */
+    for (ring = atomic_load_explicit(&rings_head, memory_order_acquire);
+         ring != NULL; ring = next) {
+        next = ring->rg_next;
+        num_dropped += atomic_load_explicit(&ring->rg_dropped, memory_order_relaxed);
+    }
+
+    if (NULL == report_stream) {
+        return;
+    }
+
+    fprintf(report_stream, "Async log: %llu records written with %llu writev() calls"
+            " (%.1f records per call), %llu dropped (ring full), %llu write errors.\n",
+            num_written, num_writev,
+            (num_writev > 0) ? (double) num_written / (double) num_writev : 0.0,
+            num_dropped, num_write_errors);
+    if (num_written > 0) {
+        ulat_show_hist(&delay_hist, "Async log: delay from queueing to written:",
+                       report_stream);
+    }
+}
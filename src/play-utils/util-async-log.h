@@ -0,0 +1,112 @@
+/*
+ * play-utils/util-async-log.h
+ *
+ * Utility module for asynchronous logging: printf-like calls store
+ * binary records (the format pointer and the raw arguments) in
+ * a per-thread ring, and a background thread formats them and
+ * writes them out in batches, with writev().
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#ifndef UTIL_ASYNC_LOG_H
+#define UTIL_ASYNC_LOG_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+/*
+ * Records per thread (a power of two).  When its ring is full,
+ * a thread drops the record instead of waiting: the point of
+ * the module is to keep the logging thread off the slow path.
+ * Dropped records are counted and reported by ualog_stop().
+ */
+#define UALOG_RING_SIZE  256
+
+/*
+ * Arguments per record, and room for the copies of the '%s' arguments
+ * (the strings usually live on the caller's stack).  A call that
+ * does not fit is formatted on the spot, with vsnprintf(),
+ * and its text is stored instead (truncated if needed).
+ */
+#define UALOG_ARGS_MAX  8
+#define UALOG_TEXT_MAX  192
+
+/*
+ * How long the writer thread sleeps when it finds all the rings empty.
+ * Producers never wake it (that would take a syscall); a record
+ * waits for at most this long before being formatted, plus
+ * the time to write the batch.
+ */
+#define UALOG_IDLE_SLEEP_NS  1000000L
+
+
+extern _Atomic int  ualog_started_;
+
+/*
+ * Flushes the stdio streams, then starts the writer thread,
+ * with all signals blocked.
+ * Returns 0 on success, or an errno value.
+ */
+int   ualog_start(void);
+
+/*
+ * Stops and joins the writer thread, then writes what is left in the rings.
+ * If 'report_stream' is not NULL, shows the number of records and
+ * writev() calls, the dropped records, and the delay from queueing
+ * a record until it was written.
+ */
+void  ualog_stop(FILE *report_stream);
+
+static inline int
+ualog_enabled (void)
+{
+    return atomic_load_explicit(&ualog_started_, memory_order_relaxed);
+}
+
+/*
+ * Waits until every record queued so far (by any thread) is written,
+ * then flushes stdout and stderr --- call it before going back to stdio,
+ * so that the output keeps its order.  Does nothing if not started.
+ */
+void  ualog_flush(void);
+
+/*
+ * Queues one record for 'fd'.  Supports the conversions of
+ * the C standard except '%n' and '%ls', without '*' widths or
+ * 'long double'; anything else is formatted on the spot.
+ *
+ * NOT async-signal-safe: the first call in a thread allocates its ring,
+ * and a handler logging in the middle of a call would corrupt the record.
+ * Cancellation is disabled during the call, so it is not
+ * a cancellation point, even when it writes directly.
+ * The ring of a thread that exits goes to the next thread that logs.
+ *
+ * When not started (or stopped meanwhile), writes the text at once,
+ * with vdprintf().
+ *
+ * Returns 0 if queued or written, -1 if dropped (ring full) or on error.
+ */
+int   ualog_printf(int fd, const char *format, ...)
+        __attribute__ ((format (printf, 2, 3)));
+
+/*
+ * Drop-in replacements for printf() and fprintf(stderr, ...)
+ * that queue a record instead when the writer thread runs.
+ */
+#define UALOG_PRINTF(...)                                   \
+    (ualog_enabled() ? ualog_printf(STDOUT_FILENO, __VA_ARGS__) \
+                     : printf(__VA_ARGS__))
+
+#define UALOG_EPRINTF(...)                                  \
+    (ualog_enabled() ? ualog_printf(STDERR_FILENO, __VA_ARGS__) \
+                     : fprintf(stderr, __VA_ARGS__))
+
+#endif  /* UTIL_ASYNC_LOG_H */
@@ -0,0 +1,78 @@
+/*
+ * play-utils/util-counters.h
+ *
+ * Utility module for per-thread event counters that can be read
+ * by another thread (a periodic reporter) while the owner keeps counting,
+ * without locks and without stdio on the owner's hot path.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#ifndef UTIL_COUNTERS_H
+#define UTIL_COUNTERS_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+
+
+/*
+ * Size of a cache line on the machines we care about (x86-64, most ARM64).
+ * A counters block gets a whole line for itself, so counting in one thread
+ * does not steal the line from a thread counting in the neighbour block.
+ */
+#define UCNT_CACHE_LINE  64
+
+enum {
+    UCNT_EVENTS,  /* what the loop is for: signals handled, wakeups, ... */
+    UCNT_CYCLES,  /* loop iterations (= blocking calls, usually) */
+    UCNT_INTR,    /* unexpected interruptions (EINTR) */
+    UCNT_FAIL,    /* other failures */
+
+    UCNT_N_SLOTS
+};
+
+typedef struct {
+    alignas(UCNT_CACHE_LINE) _Atomic unsigned long long  cnt_slots[UCNT_N_SLOTS];
+} ucnt_block;
+
+
+/*
+ * Only the owner thread may update a block, so a relaxed load plus
+ * a relaxed store is enough --- no locked read-modify-write instruction.
+ * The atomics only guarantee that a reader never sees a torn value.
+ *
+ * A NULL block is accepted (and ignored), so that
+ * loops can count unconditionally.
+ */
+static inline void
+ucnt_add (ucnt_block *cb, int slot, unsigned long long n)
+{
+    if (cb != NULL) {
+        atomic_store_explicit(&cb->cnt_slots[slot],
+                              atomic_load_explicit(&cb->cnt_slots[slot],
+                                                   memory_order_relaxed) + n,
+                              memory_order_relaxed);
+    }
+}
+
+static inline void
+ucnt_inc (ucnt_block *cb, int slot)
+{
+    ucnt_add(cb, slot, 1);
+}
+
+/*
+ * Can be called from any thread.
+ */
+static inline unsigned long long
+ucnt_get (const ucnt_block *cb, int slot)
+{
+    return atomic_load_explicit(&cb->cnt_slots[slot], memory_order_relaxed);
+}
+
+#endif  /* UTIL_COUNTERS_H */
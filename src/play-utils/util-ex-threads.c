@@ -14,17 +14,61 @@
 #include "util-ex-threads.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "util-affinity.h"
+
+
+/*
+ * Everything we know about one thread.  Each slot is allocated separately,
+ * aligned on a cache line (the alignment of 'uex_thread_info' is that of
+ * its 'counters' block), so no two threads ever write the same cache line
+ * when they update their own info.  The slots never move:
+ * the threads keep pointers to their info.
+ */
+typedef struct {
+    uex_thread_info    us_info;  /* passed to the start routine */
+
+    uex_thread_config  us_config;
+    pthread_t          us_id;
+
+    int  us_cpu_first;  /* -1 if the config string has no '@' CPU spec */
+    int  us_cpu_last;
+
+    int  us_started;  /* pthread_create() succeeded: 'us_id' is valid */
+
+    /* Values shown by the previous report, for the deltas: */
+    unsigned long long  us_report_prev[UCNT_N_SLOTS];
+} uex_thread_slot;
 
 static int  uex_n_threads = 0;
+static int  uex_n_slots_alloc = 0;  /* capacity of the pointers array */
+
+static uex_thread_slot **uex_slots = NULL;
+
+static int  uex_quiet = 0;
 
-static uex_thread_config  uex_thread_configs[UEX_THREADS_MAX];
 
-static uex_thread_info  uex_thread_structs[UEX_THREADS_MAX];
-static pthread_t        uex_thread_ids[UEX_THREADS_MAX];
+static unsigned long long
+uex_monotonic_ns (void)
+{
+    struct timespec  tspec;
+
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+
+    return (unsigned long long) tspec.tv_sec * 1000000000ULL
+           + (unsigned long long) tspec.tv_nsec;
+}
+
+void
+uex_set_quiet (int quiet)
+{
+    uex_quiet = quiet;
+}
 
 
 int
@@ -48,7 +92,7 @@ uex_find_thread_config_by_prefix (const char *config_str, size_t len_to_check)
     assert(uex_n_threads <= UEX_THREADS_MAX);
 
     for (ix = 0; ix < uex_n_threads; ++ix) {
-        if (0 == strncmp(config_str, uex_thread_configs[ix].uc_config_buf, len_to_check)) {
+        if (0 == strncmp(config_str, uex_slots[ix]->us_config.uc_config_buf, len_to_check)) {
             return ix;
         }
     }
@@ -62,7 +106,15 @@ uex_add_thread_config (const char *config_str,
                        void * (*start_routine)(void *))
 {
     const size_t  len = strlen(config_str);
+    const char   *cpu_spec = strrchr(config_str, '@');
 
+    uex_thread_slot  **new_slots;
+    uex_thread_slot   *slot;
+    void              *mem;
+
+    int  new_alloc;
+    int  cpu_first = -1;
+    int  cpu_last = -1;
     int  pos;
 
     if (len > UEX_THREAD_CONFIG_MAX) {
@@ -75,17 +127,89 @@ uex_add_thread_config (const char *config_str,
         return -2;
     }
 
-    pos = uex_n_threads++;
+    if (cpu_spec != NULL) {
+        if (uaff_parse_cpu_range(cpu_spec + 1, &cpu_first, &cpu_last) != 0) {
+            return -3;
+        }
+    }
+
+    if (uex_n_threads == uex_n_slots_alloc) {
+        new_alloc = (uex_n_slots_alloc > 0) ? 2 * uex_n_slots_alloc : 16;
+        if (new_alloc > UEX_THREADS_MAX) {
+            new_alloc = UEX_THREADS_MAX;
+        }
+
+        new_slots = realloc(uex_slots, new_alloc * sizeof uex_slots[0]);
+        if (NULL == new_slots) {
+            return -4;
+        }
+        uex_slots = new_slots;
+        uex_n_slots_alloc = new_alloc;
+    }
+
+    if (posix_memalign(&mem, UCNT_CACHE_LINE, sizeof *slot) != 0) {
+        return -4;
+    }
+    slot = mem;
+    memset(slot, 0, sizeof *slot);
+
+    memcpy(slot->us_config.uc_config_buf, config_str, len);
+    slot->us_config.uc_config_buf[len] = '\0';
 
-    memcpy(uex_thread_configs[pos].uc_config_buf, config_str, len);
-    uex_thread_configs[pos].uc_config_buf[len] = '\0';
+    slot->us_config.uc_attr = attr;
+    slot->us_config.uc_start_routine = start_routine;
 
-    uex_thread_configs[pos].uc_attr = attr;
-    uex_thread_configs[pos].uc_start_routine = start_routine;
+    slot->us_cpu_first = cpu_first;
+    slot->us_cpu_last = cpu_last;
+
+    pos = uex_n_threads++;
+    uex_slots[pos] = slot;
 
     return pos;
 }
 
+void
+uex_clear_thread_configs (void)
+{
+    int  ix;
+
+    assert(0 <= uex_n_threads);
+    assert(uex_n_threads <= UEX_THREADS_MAX);
+
+    for (ix = 0; ix < uex_n_threads; ++ix) {
+        free(uex_slots[ix]);
+        uex_slots[ix] = NULL;
+    }
+
+    uex_n_threads = 0;
+}
+
+/*
+ * Every thread starts here: applies the CPU affinity requested
+ * in the config string (if any), then runs the real start routine.
+ * The affinity could be set in a copy of the thread attributes instead,
+ * but the attributes objects belong to the caller, maybe shared.
+ */
+static void *
+uex_thread_trampoline (void *arg)
+{
+    uex_thread_slot *const  slot = arg;
+
+    int  aff_res;
+
+    if (slot->us_cpu_first >= 0) {
+        aff_res = uaff_pin_current_thread(slot->us_cpu_first, slot->us_cpu_last);
+        if (aff_res != 0) {
+            /* Not fatal: the experiment still runs, just not where requested. */
+            fprintf(stderr, "[%d] Could not set CPU affinity %d-%d for '%s': errno value %d.\n",
+                    slot->us_info.pos, slot->us_cpu_first, slot->us_cpu_last,
+                    slot->us_config.uc_config_buf, aff_res);
+        }
+    }
+
+    return slot->us_config.uc_start_routine(&slot->us_info);
+}
+
 static int
 uex_start_one_thread (int pos)
 {
@@ -99,23 +223,26 @@ uex_start_one_thread (int pos)
     assert(pos < uex_n_threads);
 
     /* The entry must not be in use: */
-    assert(NULL == uex_thread_structs[pos].config_str);
+    assert(NULL == uex_slots[pos]->us_info.config_str);
 
-    /* DO NOT check: (NULL == uex_thread_ids[pos]);
+    /* DO NOT check: (NULL == uex_slots[pos]->us_id);
      * zero is neither safer nor more portable than NULL for this purpose.
      * 'pthread_t' is NOT guaranteed to be a pointer or integer.
      */
 
-    memset(&uex_thread_structs[pos], 0, sizeof uex_thread_structs[0]);
+    memset(&uex_slots[pos]->us_info, 0, sizeof uex_slots[0]->us_info);
 
-    uex_thread_structs[pos].config_str = uex_thread_configs[pos].uc_config_buf;
+    uex_slots[pos]->us_info.config_str = uex_slots[pos]->us_config.uc_config_buf;
+    uex_slots[pos]->us_info.pos = pos;
 
     tcreate_res = pthread_create(
-                    &uex_thread_ids[pos],
-                    uex_thread_configs[pos].uc_attr,
-                    uex_thread_configs[pos].uc_start_routine,
-                    &uex_thread_structs[pos]);
-    if (tcreate_res != 0) {
+                    &uex_slots[pos]->us_id,
+                    uex_slots[pos]->us_config.uc_attr,
+                    &uex_thread_trampoline,
+                    uex_slots[pos]);
+    if (tcreate_res == 0) {
+        uex_slots[pos]->us_started = 1;
+    } else {
         res = strerror_r(tcreate_res, err_buf, sizeof err_buf);
         if (res != 0) {
             fprintf(stderr, "[%d] strerror_r(%d) failed, returning the errno value %d.\n",
@@ -125,25 +252,30 @@ uex_start_one_thread (int pos)
 
         printf("[%d] pthread_create() failed for '%s',"
                " returning the errno value %d = %s\n",
-               pos, uex_thread_configs[pos].uc_config_buf,
+               pos, uex_slots[pos]->us_config.uc_config_buf,
                tcreate_res, err_buf);
     }
 
     return tcreate_res;
 }
 
-void
+int
 uex_start_threads (void)
 {
     unsigned long  num_success = 0;
     unsigned long  num_start_fail = 0;
 
+    unsigned long long  t_begin;
+    unsigned long long  elapsed_ns;
+
     int  start_res;
     int  ix;
 
     assert(0 <= uex_n_threads);
     assert(uex_n_threads <= UEX_THREADS_MAX);
 
+    t_begin = uex_monotonic_ns();
+
     for (ix = 0; ix < uex_n_threads; ++ix) {
         start_res = uex_start_one_thread(ix);
         if (start_res != 0) {
@@ -153,8 +285,12 @@ uex_start_threads (void)
         }
     }
 
-    printf("Started %lu, failed %lu\n",
-           num_success, num_start_fail);
+    elapsed_ns = uex_monotonic_ns() - t_begin;
+
+    printf("Started %lu, failed %lu in %.3f ms (%.1f usec per thread)\n",
+           num_success, num_start_fail, elapsed_ns / 1e6,
+           (uex_n_threads > 0) ? elapsed_ns / 1e3 / uex_n_threads : 0.0);
+    return (int) num_success;
 }
 
 
@@ -172,16 +308,22 @@ uex_cancel_one_thread (int pos)
     assert(0 <= pos);
     assert(pos < uex_n_threads);
 
-    config_str = uex_thread_configs[pos].uc_config_buf;
+    config_str = uex_slots[pos]->us_config.uc_config_buf;
+
+    if (!uex_slots[pos]->us_started) {
+        return -1;  /* pthread_create() failed, already reported */
+    }
 
-    tcancel_res = pthread_cancel(uex_thread_ids[pos]);
+    tcancel_res = pthread_cancel(uex_slots[pos]->us_id);
 
     if (tcancel_res == 0) {
         /* The cancellation request was made succesfully, but
          * the target thread is not required to act on it immediately.
          */
-        printf("[%d] Cancellation request sent for thread '%s'.\n",
-               pos, config_str);
+        if (!uex_quiet) {
+            printf("[%d] Cancellation request sent for thread '%s'.\n",
+                   pos, config_str);
+        }
         return 0;
     } else {
         res = strerror_r(tcancel_res, err_buf, sizeof err_buf);
@@ -248,23 +390,34 @@ uex_join_one_thread (int pos)
     assert(0 <= pos);
     assert(pos < uex_n_threads);
 
-    curr_info = &uex_thread_structs[pos];
-    config_str = uex_thread_configs[pos].uc_config_buf;
+    curr_info = &uex_slots[pos]->us_info;
+    config_str = uex_slots[pos]->us_config.uc_config_buf;
+
+    if (!uex_slots[pos]->us_started) {
+        return 2;  /* pthread_create() failed, already reported */
+    }
 
-    printf("[%d] Trying to join thread '%s' ...\n",
-           pos, config_str);
+    if (!uex_quiet) {
+        printf("[%d] Trying to join thread '%s' ...\n",
+               pos, config_str);
+    }
 
-    tjoin_res = pthread_join(uex_thread_ids[pos], &thr_retval);
+    tjoin_res = pthread_join(uex_slots[pos]->us_id, &thr_retval);
+    uex_slots[pos]->us_started = 0;
 
     if (tjoin_res == 0) {
         if (PTHREAD_CANCELED == thr_retval) {
-            printf("[%d] PTHREAD_CANCELED (thread '%s')\n",
-                   pos, config_str);
+            if (!uex_quiet) {
+                printf("[%d] PTHREAD_CANCELED (thread '%s')\n",
+                       pos, config_str);
+            }
             return 1;
         } else {
             if (curr_info == thr_retval) {
-                printf("[%d] normal exit for thread '%s', expected value\n",
-                       pos, config_str);
+                if (!uex_quiet) {
+                    printf("[%d] normal exit for thread '%s', expected value\n",
+                           pos, config_str);
+                }
                 return 0;
             } else {
                 printf("[%d] normal exit for thread '%s', unexpected value\n",
@@ -293,12 +446,17 @@ uex_join_threads (void)
     unsigned long  num_canceled = 0;
     unsigned long  num_join_fail = 0;
 
+    unsigned long long  t_begin;
+    unsigned long long  elapsed_ns;
+
     int  join_res;
     int  ix;
 
     assert(0 <= uex_n_threads);
     assert(uex_n_threads <= UEX_THREADS_MAX);
 
+    t_begin = uex_monotonic_ns();
+
     for (ix = 0; ix < uex_n_threads; ++ix) {
         join_res = uex_join_one_thread(ix);
         switch (join_res)
@@ -317,6 +475,211 @@ uex_join_threads (void)
         }
     }
 
-    printf("Normal exit: %lu, canceled: %lu; %lu could not be joined.\n",
-           num_normal, num_canceled, num_join_fail);
+    elapsed_ns = uex_monotonic_ns() - t_begin;
+
+    /*
+     * The join time includes waiting for the threads to finish,
+     * so it only means "join cost" when they were already finished.
+     */
+    printf("Normal exit: %lu, canceled: %lu; %lu could not be joined"
+           " (joining took %.3f ms).\n",
+           num_normal, num_canceled, num_join_fail, elapsed_ns / 1e6);
+}
+
+
+static const char *const  uex_slot_names[UCNT_N_SLOTS] = {
+    "events", "cycles", "intr", "fail"
+};
+
+static pthread_mutex_t  uex_reporter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   uex_reporter_cond;  /* initialized with CLOCK_MONOTONIC */
+static int              uex_reporter_stop = 0;  /* protected by the mutex */
+
+static int        uex_reporter_running = 0;
+static pthread_t  uex_reporter_id;
+
+static double  uex_report_period_s;
+static FILE   *uex_report_stream;
+
+static unsigned long long  uex_report_prev_ns;
+static unsigned long long  uex_report_start_ns;
+
+static void
+uex_show_counters (const char *what)
+{
+    unsigned long long  totals[UCNT_N_SLOTS] = {0};
+    unsigned long long  total_deltas[UCNT_N_SLOTS] = {0};
+    unsigned long long  value;
+    unsigned long long  now_ns;
+    double  interval_s;
+
+    FILE *const  out_stream = uex_report_stream;
+
+    int  ix;
+    int  slot;
+
+    now_ns = uex_monotonic_ns();
+    interval_s = (double) (now_ns - uex_report_prev_ns) / 1e9;
+    if (interval_s <= 0.0) {
+        interval_s = 1e-9;
+    }
+
+    fprintf(out_stream, "--- Counters %s at %.3f s (last %.3f s):\n",
+            what, (double) (now_ns - uex_report_start_ns) / 1e9, interval_s);
+
+    for (ix = 0; ix < uex_n_threads; ++ix) {
+        if (NULL == uex_slots[ix]->us_info.config_str) {
+            continue;  /* not started yet */
+        }
+
+        fprintf(out_stream, "  %-12s", uex_slots[ix]->us_info.config_str);
+        for (slot = 0; slot < UCNT_N_SLOTS; ++slot) {
+            value = ucnt_get(&uex_slots[ix]->us_info.counters, slot);
+
+            fprintf(out_stream, " %s %llu (+%llu, %.0f/s)%s",
+                    uex_slot_names[slot], value,
+                    value - uex_slots[ix]->us_report_prev[slot],
+                    (double) (value - uex_slots[ix]->us_report_prev[slot]) / interval_s,
+                    (slot + 1 < UCNT_N_SLOTS) ? "," : "\n");
+
+            totals[slot] += value;
+            total_deltas[slot] += value - uex_slots[ix]->us_report_prev[slot];
+            uex_slots[ix]->us_report_prev[slot] = value;
+        }
+    }
+
+    fprintf(out_stream, "  %-12s", "(all)");
+    for (slot = 0; slot < UCNT_N_SLOTS; ++slot) {
+        fprintf(out_stream, " %s %llu (+%llu, %.0f/s)%s",
+                uex_slot_names[slot], totals[slot], total_deltas[slot],
+                (double) total_deltas[slot] / interval_s,
+                (slot + 1 < UCNT_N_SLOTS) ? "," : "\n");
+    }
+
+    fflush(out_stream);
+
+    uex_report_prev_ns = now_ns;
+}
+
+static void *
+uex_reporter_thread_func (void *arg)
+{
+    struct timespec  deadline;
+
+    unsigned long long  period_ns;
+    unsigned long long  deadline_ns;
+
+    int  stopping;
+    int  res;
+
+    (void) arg;
+
+    period_ns = (unsigned long long) (uex_report_period_s * 1e9);
+    deadline_ns = uex_report_start_ns;
+
+    pthread_mutex_lock(&uex_reporter_mutex);
+    do {
+        /* Fixed schedule: the time spent printing does not add drift. */
+        deadline_ns += period_ns;
+        deadline.tv_sec = (time_t) (deadline_ns / 1000000000ULL);
+        deadline.tv_nsec = (long) (deadline_ns % 1000000000ULL);
+
+        res = 0;
+        while (!uex_reporter_stop && res != ETIMEDOUT) {
+            res = pthread_cond_timedwait(&uex_reporter_cond, &uex_reporter_mutex,
+                                         &deadline);
+        }
+        stopping = uex_reporter_stop;
+
+        /* No need to hold the mutex while printing: */
+        pthread_mutex_unlock(&uex_reporter_mutex);
+        uex_show_counters(stopping ? "(final)" : "");
+        pthread_mutex_lock(&uex_reporter_mutex);
+    } while (!stopping);
+    pthread_mutex_unlock(&uex_reporter_mutex);
+
+    return NULL;
+}
+
+int
+uex_start_reporter (double period_s, FILE *out_stream)
+{
+    pthread_condattr_t  cattr;
+
+    char  err_buf[128];
+    int   res;
+    int   tcreate_res;
+    int   ix;
+
+    assert(!uex_reporter_running);
+    assert(period_s > 0.0);
+
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&uex_reporter_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    uex_reporter_stop = 0;
+    uex_report_period_s = period_s;
+    uex_report_stream = out_stream;
+
+    for (ix = 0; ix < uex_n_threads; ++ix) {
+        memset(uex_slots[ix]->us_report_prev, 0, sizeof uex_slots[ix]->us_report_prev);
+    }
+    uex_report_start_ns = uex_monotonic_ns();
+    uex_report_prev_ns = uex_report_start_ns;
+
+    tcreate_res = pthread_create(&uex_reporter_id, NULL,
+                                 &uex_reporter_thread_func, NULL);
+    if (tcreate_res != 0) {
+        res = strerror_r(tcreate_res, err_buf, sizeof err_buf);
+        if (res != 0) {
+            fprintf(stderr, "[reporter] strerror_r(%d) failed, returning the errno value %d.\n",
+                    tcreate_res, res);
+            exit(96);
+        }
+
+        printf("pthread_create() failed for the counters reporter,"
+               " returning the errno value %d = %s\n",
+               tcreate_res, err_buf);
+        pthread_cond_destroy(&uex_reporter_cond);
+        return tcreate_res;
+    }
+
+    uex_reporter_running = 1;
+    return 0;
+}
+
+void
+uex_stop_reporter (void)
+{
+    char  err_buf[128];
+    int   res;
+    int   tjoin_res;
+
+    if (!uex_reporter_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&uex_reporter_mutex);
+    uex_reporter_stop = 1;
+    pthread_cond_signal(&uex_reporter_cond);
+    pthread_mutex_unlock(&uex_reporter_mutex);
+
+    tjoin_res = pthread_join(uex_reporter_id, NULL);
+    if (tjoin_res != 0) {
+        res = strerror_r(tjoin_res, err_buf, sizeof err_buf);
+        if (res != 0) {
+            fprintf(stderr, "[reporter] strerror_r(%d) failed, returning the errno value %d.\n",
+                    tjoin_res, res);
+            exit(95);
+        }
+
+        printf("pthread_join() failed for the counters reporter,"
+               " returning the errno value %d = %s\n",
+               tjoin_res, err_buf);
+    }
+
+    pthread_cond_destroy(&uex_reporter_cond);
+    uex_reporter_running = 0;
 }
@@ -12,9 +12,15 @@
  */
 
 #include <pthread.h>
+#include <stdio.h>
 
+#include "util-counters.h"
 
-#define UEX_THREADS_MAX  12  /* Maximum number of threads that can be tracked */
+
+/*
+ * Sanity limit, not a size: the registry grows as needed.
+ */
+#define UEX_THREADS_MAX  4096  /* Maximum number of threads that can be tracked */
 #define UEX_THREAD_CONFIG_MAX  31  /* Maximum length of config string */
 #define UEX_THREAD_MESSAGE_MAX  67  /* Maximum length of stored message */
 
@@ -42,8 +48,15 @@ typedef struct {
      */
     unsigned long long  count;
 
+    /* Updated only by the thread itself, read by the reporter
+     * (see uex_start_reporter() below); has a cache line of its own.
+     */
+    ucnt_block  counters;
+
     const char *config_str;
 
+    int  pos;  /* index of the thread config; handy for per-thread arrays */
+
     char  message_buf[UEX_THREAD_MESSAGE_MAX + 1];
 } uex_thread_info;
 
@@ -63,11 +76,51 @@ int  uex_find_thread_config_by_prefix(const char *config_str, size_t len_to_chec
  * to this module; the caller is responsible for proper disposal of
  * the thread attributes objects it provided, when they are not needed
  * anymore --- after uex_join_threads() it's sure we are finished.
+ *
+ * The config string may end with a CPU affinity spec:
+ * '@N' pins the thread to CPU N, '@N-M' to the CPUs N to M (inclusive);
+ * for example "w3@2", "s1@0-7".  Applied by the new thread itself,
+ * before calling 'start_routine'.
+ *
+ * Returns the position of the new config, or a negative value:
+ * -1 = config string too long, -2 = too many threads,
+ * -3 = bad CPU affinity spec, -4 = out of memory.
  */
 int  uex_add_thread_config(const char *config_str,
                            const pthread_attr_t *attr,
                            void * (*start_routine)(void *));
 
-void  uex_start_threads(void);
+/*
+ * Forget all the thread configs (and the info records of the threads),
+ * so a new set of threads can be configured and started.
+ * Only after uex_join_threads(): none of the threads may still run.
+ */
+void  uex_clear_thread_configs(void);
+
+/*
+ * Quiet: no messages for each thread started/canceled/joined successfully;
+ * only the failures and the summary lines (with timing) are shown.
+ * Useful with hundreds of threads.
+ */
+void  uex_set_quiet(int quiet);
+
+/*
+ * Returns the number of threads started; a thread that failed to start
+ * is reported, and skipped by the other functions.
+ */
+int   uex_start_threads(void);
 void  uex_cancel_threads(void);
 void  uex_join_threads(void);
+
+/*
+ * Periodic reporter: a separate thread that shows, every 'period_s' seconds,
+ * the 'counters' of each started thread --- values, deltas and rates.
+ * Must be started after uex_start_threads().
+ * uex_stop_reporter() shows a final snapshot, so it is best called
+ * after uex_join_threads().
+ *
+ * Returns 0 on success, or an errno value if the reporter thread could not
+ * be created.
+ */
+int   uex_start_reporter(double period_s, FILE *out_stream);
+void  uex_stop_reporter(void);
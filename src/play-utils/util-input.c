@@ -10,12 +10,18 @@
  *  if you want to)
  */
 
+#define _GNU_SOURCE  /* for splice() */
+
 #include "util-input.h"
 
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>  /* for FIONREAD */
+#include <sys/stat.h>
+#include <termios.h>
 #include <unistd.h>
 
 /*
@@ -32,7 +38,10 @@
 #endif
 
 
-#define DISCARD_BUF_MAX  1024
+#define DISCARD_BUF_MAX  1024  /* on the stack; bigger ones are allocated */
+
+/* reads sized by FIONREAD are capped to this */
+#define DISCARD_READ_MAX  (64 * 1024)
 
 
 static int
@@ -53,49 +62,130 @@ get_first_input_char_ (int in_fd, FILE *report_stream)
     return buf[0];
 }
 
-void
+long long
 discard_input (int in_fd, FILE *report_stream, size_t bufsize)
 {
-    unsigned long long  num_discarded = 0;
-    char  buf[DISCARD_BUF_MAX];
+    long long  num_discarded = 0;
+    char  stack_buf[DISCARD_BUF_MAX];
+    char *buf = stack_buf;
 
     ssize_t  num_read;
-    errno_t  read_err;
-
-    assert(bufsize <= DISCARD_BUF_MAX);
+    errno_t  read_err = 0;
 
-    fprintf(report_stream, "\nDiscarding input from fd %d, buf[%zu]: ",
-            in_fd, bufsize);
-    fflush(report_stream);
+    if (bufsize > DISCARD_BUF_MAX) {
+        buf = malloc(bufsize);
+        if (NULL == buf) {
+            perror("discard_input: malloc");
+            return -1;
+        }
+    }
 
     do {
+        read_err = 0;  /* only the last read counts: an EINTR may be retried */
         num_read = read(in_fd, buf, bufsize);
-        read_err = errno;
-
-        fprintf(report_stream, "%zd, ", num_read);
-        fflush(report_stream);
 
         if (num_read < 0) {
+            read_err = errno;
+            if (EINTR == read_err) {
+                continue;
+            }
             if (EAGAIN != read_err) {
                 fprintf(stderr, "discard_input: read(%d) error %d = %s\n",
                         in_fd, read_err, strerror(read_err));
             }
-
-            return;
+            break;
         }
 
         num_discarded += num_read;
-    } while (num_read > 0);
+    } while (num_read != 0);
 
-    fprintf(report_stream, "Discarded %llu bytes.\n", num_discarded);
-    fflush(report_stream);
+    if (buf != stack_buf) {
+        free(buf);
+    }
+
+    if (report_stream != NULL) {
+        fprintf(report_stream, "\nDiscarded %lld bytes from fd %d (%s).\n",
+                num_discarded, in_fd, (0 == num_read) ? "EOF" : "no more pending");
+        fflush(report_stream);
+    }
+
+    return (read_err != 0 && read_err != EAGAIN) ? -1 : num_discarded;
 }
 
-int
-discard_pending_input (int in_fd, FILE *report_stream)
+/*
+ * Discards exactly 'pending' bytes, that are known to be there (FIONREAD),
+ * so no read can block: moved to /dev/null with splice() if 'in_fd'
+ * is a pipe, otherwise read into a buffer.
+ */
+static long long
+discard_known_pending_ (int in_fd, long long pending, int is_pipe)
+{
+    long long  num_discarded = 0;
+
+    char *buf = NULL;
+
+    size_t   chunk;
+    ssize_t  n;
+
+    int  null_fd = -1;
+
+    if (is_pipe) {
+        null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    }
+
+    while (num_discarded < pending) {
+        chunk = (size_t) (pending - num_discarded);
+
+        if (null_fd >= 0) {
+            n = splice(in_fd, NULL, null_fd, NULL, chunk, SPLICE_F_MOVE);
+            if (n < 0 && EINVAL == errno) {
+                close(null_fd);  /* not supported here: read() instead */
+                null_fd = -1;
+                continue;
+            }
+        } else {
+            if (NULL == buf) {
+                buf = malloc(DISCARD_READ_MAX);
+                if (NULL == buf) {
+                    perror("discard_pending_input: malloc");
+                    break;
+                }
+            }
+            n = read(in_fd, buf, (chunk < DISCARD_READ_MAX) ? chunk : DISCARD_READ_MAX);
+        }
+
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            fprintf(stderr, "discard_pending_input: %s(%d) error %d = %s\n",
+                    (null_fd >= 0) ? "splice" : "read", in_fd, errno, strerror(errno));
+            break;
+        }
+        if (0 == n) {
+            break;  /* someone else got there first */
+        }
+        num_discarded += n;
+    }
+
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+    free(buf);
+
+    return num_discarded;
+}
+
+/*
+ * The fallback, for inputs that do not support FIONREAD:
+ * non-blocking reads until EAGAIN.
+ */
+static long long
+discard_nonblocking_ (int in_fd)
 {
+    long long  num_discarded;
+
     int  res;
-    int  new_flags;
 
     const int  old_flags = fcntl(in_fd, F_GETFL, 0);
 
@@ -105,26 +195,76 @@ discard_pending_input (int in_fd, FILE *report_stream)
     }
 
     if ((old_flags & O_NONBLOCK) == O_NONBLOCK) {
-        discard_input(in_fd, report_stream, DISCARD_BUF_MAX);
-    } else {
-        new_flags = old_flags | O_NONBLOCK;
+        return discard_input(in_fd, NULL, DISCARD_READ_MAX);
+    }
 
-        res = fcntl(in_fd, F_SETFL, new_flags);
-        if (res < 0) {
-            perror("discard_pending_input: fcntl F_SETFL setting O_NONBLOCK");
-            return -3;
-        }
+    res = fcntl(in_fd, F_SETFL, old_flags | O_NONBLOCK);
+    if (res < 0) {
+        perror("discard_pending_input: fcntl F_SETFL setting O_NONBLOCK");
+        return -3;
+    }
 
-        discard_input(in_fd, report_stream, DISCARD_BUF_MAX);
+    num_discarded = discard_input(in_fd, NULL, DISCARD_READ_MAX);
 
-        res = fcntl(in_fd, F_SETFL, old_flags);
-        if (res < 0) {
-            perror("discard_pending_input: fcntl F_SETFL restoring");
-            return -4;
+    res = fcntl(in_fd, F_SETFL, old_flags);
+    if (res < 0) {
+        perror("discard_pending_input: fcntl F_SETFL restoring");
+        return -4;
+    }
+
+    return num_discarded;
+}
+
+long long
+discard_pending_input (int in_fd, FILE *report_stream)
+{
+    struct stat  st;
+
+    const char *how;
+
+    long long  num_discarded;
+    off_t      pos;
+
+    int  pending = 0;
+
+    if (fstat(in_fd, &st) < 0) {
+        perror("discard_pending_input: fstat");
+        return -1;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+        /* "Pending" is everything up to the end: just skip it. */
+        pos = lseek(in_fd, 0, SEEK_CUR);
+        if (pos < 0 || lseek(in_fd, 0, SEEK_END) < 0) {
+            perror("discard_pending_input: lseek");
+            return -1;
+        }
+        num_discarded = (st.st_size > pos) ? (long long) (st.st_size - pos) : 0;
+        how = "lseek";
+    } else if (ioctl(in_fd, FIONREAD, &pending) < 0) {
+        num_discarded = discard_nonblocking_(in_fd);
+        how = "non-blocking read";
+    } else if (isatty(in_fd)) {
+        /* The count is only informative: tcflush() drops all of it,
+         * including what arrives meanwhile. */
+        if (tcflush(in_fd, TCIFLUSH) < 0) {
+            perror("discard_pending_input: tcflush");
+            return -1;
         }
+        num_discarded = pending;
+        how = "tcflush";
+    } else {
+        num_discarded = discard_known_pending_(in_fd, pending, S_ISFIFO(st.st_mode));
+        how = S_ISFIFO(st.st_mode) ? "splice" : "read";
+    }
+
+    if (report_stream != NULL && num_discarded > 0) {
+        fprintf(report_stream, "\nDiscarded %lld bytes of pending input from fd %d (%s).\n",
+                num_discarded, in_fd, how);
+        fflush(report_stream);
     }
 
-    return 0;
+    return num_discarded;
 }
 
 int
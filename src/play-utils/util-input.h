@@ -13,8 +13,22 @@
 #include <stdio.h>
 
 
-void  discard_input(int in_fd, FILE *report_stream, size_t bufsize);
-int   discard_pending_input(int in_fd, FILE *report_stream);
+/*
+ * Reads and throws away until EOF (or EAGAIN, if 'in_fd' is non-blocking),
+ * 'bufsize' bytes at a time.  Prints one summary line to 'report_stream'
+ * unless it is NULL.  Returns the number of bytes discarded, or -1.
+ */
+long long  discard_input(int in_fd, FILE *report_stream, size_t bufsize);
+
+/*
+ * Discards what can be read without blocking: lseek() to the end for
+ * regular files, tcflush() for terminals, splice() to /dev/null for pipes,
+ * reads sized by FIONREAD otherwise (or non-blocking reads until EAGAIN
+ * if FIONREAD is not supported).  Prints one line to 'report_stream'
+ * (may be NULL) if anything was discarded.
+ * Returns the number of bytes discarded, or a negative value on errors.
+ */
+long long  discard_pending_input(int in_fd, FILE *report_stream);
 
 int  wait_for_input_char(int in_fd, FILE *report_stream);
 
@@ -0,0 +1,209 @@
+/*
+ * play-utils/util-latency.c
+ *
+ * Utility module for measuring latencies:
+ * monotonic clock readings in nanoseconds, and
+ * a log-linear histogram that can report percentiles.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "util-latency.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+
+static const unsigned long long  nanosec_per_sec = 1000000000ULL;
+
+unsigned long long
+ulat_now_ns (void)
+{
+    struct timespec  tspec;
+
+    /* Cannot fail for CLOCK_MONOTONIC with a valid pointer;
+     * not worth an error path in code that runs in tight loops.
+     */
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+
+    return (unsigned long long) tspec.tv_sec * nanosec_per_sec
+           + (unsigned long long) tspec.tv_nsec;
+}
+
+
+/*
+ * Values below ULAT_SUB_BUCKETS get one bucket each;
+ * above that, each power of two [2^k, 2^(k+1)) is split into
+ * ULAT_SUB_BUCKETS equal parts, indexed by the 4 bits after the leading one.
+ */
+static int
+bucket_index_ (unsigned long long value)
+{
+    int  msb;
+
+    if (value < ULAT_SUB_BUCKETS) {
+        return (int) value;
+    }
+
+    msb = 63 - __builtin_clzll(value);  /* GCC builtin; 'value' is not zero */
+
+    return ULAT_SUB_BUCKETS * (msb - 3)
+           + (int) ((value >> (msb - 4)) & (ULAT_SUB_BUCKETS - 1));
+}
+
+static unsigned long long
+bucket_low_ (int ix)
+{
+    int  msb;
+    int  sub;
+
+    if (ix < ULAT_SUB_BUCKETS) {
+        return (unsigned long long) ix;
+    }
+
+    msb = ix / ULAT_SUB_BUCKETS + 3;
+    sub = ix % ULAT_SUB_BUCKETS;
+
+    return (unsigned long long) (ULAT_SUB_BUCKETS + sub) << (msb - 4);
+}
+
+static unsigned long long
+bucket_width_ (int ix)
+{
+    if (ix < 2 * ULAT_SUB_BUCKETS) {
+        return 1;
+    }
+
+    return 1ULL << (ix / ULAT_SUB_BUCKETS - 1);
+}
+
+
+void
+ulat_hist_reset (ulat_hist *lh)
+{
+    memset(lh, 0, sizeof *lh);
+}
+
+void
+ulat_hist_add (ulat_hist *lh, unsigned long long value_ns)
+{
+    if (0 == lh->lh_count || value_ns < lh->lh_min) {
+        lh->lh_min = value_ns;
+    }
+    if (value_ns > lh->lh_max) {
+        lh->lh_max = value_ns;
+    }
+
+    ++lh->lh_count;
+    lh->lh_sum += value_ns;
+
+    ++lh->lh_buckets[bucket_index_(value_ns)];
+}
+
+void
+ulat_hist_merge (ulat_hist *dest, const ulat_hist *src)
+{
+    int  ix;
+
+    if (0 == src->lh_count) {
+        return;
+    }
+
+    if (0 == dest->lh_count || src->lh_min < dest->lh_min) {
+        dest->lh_min = src->lh_min;
+    }
+    if (src->lh_max > dest->lh_max) {
+        dest->lh_max = src->lh_max;
+    }
+
+    dest->lh_count += src->lh_count;
+    dest->lh_sum += src->lh_sum;
+
+    for (ix = 0; ix < ULAT_N_BUCKETS; ++ix) {
+        dest->lh_buckets[ix] += src->lh_buckets[ix];
+    }
+}
+
+unsigned long long
+ulat_hist_percentile (const ulat_hist *lh, double pct)
+{
+    double  exact_rank;
+
+    unsigned long long  rank;
+    unsigned long long  seen = 0;
+    unsigned long long  value;
+
+    int  ix;
+
+    if (0 == lh->lh_count) {
+        return 0;
+    }
+
+    if (pct <= 0.0) {
+        return lh->lh_min;
+    }
+    if (pct >= 100.0) {
+        return lh->lh_max;
+    }
+
+    /*
+     * Rank of the wanted sample, counting from one (nearest-rank method):
+     * ceil(pct / 100 * count), without libm.
+     */
+    exact_rank = pct / 100.0 * (double) lh->lh_count;
+    rank = (unsigned long long) exact_rank;
+    if ((double) rank < exact_rank) {
+        ++rank;
+    }
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > lh->lh_count) {
+        rank = lh->lh_count;
+    }
+
+    for (ix = 0; ix < ULAT_N_BUCKETS; ++ix) {
+        seen += lh->lh_buckets[ix];
+        if (seen >= rank) {
+            /* Middle of the bucket, but never outside the observed range: */
+            value = bucket_low_(ix) + bucket_width_(ix) / 2;
+            if (value < lh->lh_min) {
+                value = lh->lh_min;
+            }
+            if (value > lh->lh_max) {
+                value = lh->lh_max;
+            }
+            return value;
+        }
+    }
+
+    assert(0);  /* the bucket counts must add up to 'lh_count' */
+    return lh->lh_max;
+}
+
+void
+ulat_show_hist (const ulat_hist *lh, const char *message_preamble,
+                FILE *out_stream)
+{
+    if (0 == lh->lh_count) {
+        fprintf(out_stream, "%s no samples.\n", message_preamble);
+        return;
+    }
+
+    fprintf(out_stream, "%s n=%llu, usec: min %.3f, p50 %.3f, p90 %.3f,"
+            " p99 %.3f, p99.9 %.3f, max %.3f; mean %.3f\n",
+            message_preamble, lh->lh_count,
+            lh->lh_min / 1e3,
+            ulat_hist_percentile(lh, 50.0) / 1e3,
+            ulat_hist_percentile(lh, 90.0) / 1e3,
+            ulat_hist_percentile(lh, 99.0) / 1e3,
+            ulat_hist_percentile(lh, 99.9) / 1e3,
+            lh->lh_max / 1e3,
+            (double) lh->lh_sum / (double) lh->lh_count / 1e3);
+}
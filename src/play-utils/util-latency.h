@@ -0,0 +1,87 @@
+/*
+ * play-utils/util-latency.h
+ *
+ * Utility module for measuring latencies:
+ * monotonic clock readings in nanoseconds, and
+ * a log-linear histogram that can report percentiles.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+/*
+ * Each power of two is split into this many equal sub-buckets,
+ * so a recorded value is known with a relative error below 1/16 ---
+ * good enough for percentiles, and the whole histogram fits in 8 KBytes.
+ */
+#define ULAT_SUB_BUCKETS  16
+#define ULAT_N_BUCKETS  (ULAT_SUB_BUCKETS * 61)  /* covers the full 64-bit range */
+
+
+typedef struct {
+    unsigned long long  lh_count;
+    unsigned long long  lh_sum;
+    unsigned long long  lh_min;
+    unsigned long long  lh_max;
+
+    unsigned long long  lh_buckets[ULAT_N_BUCKETS];
+} ulat_hist;
+
+
+/*
+ * CLOCK_MONOTONIC reading, in nanoseconds.
+ * Async-signal-safe (clock_gettime() is, per POSIX).
+ */
+unsigned long long  ulat_now_ns(void);
+
+/*
+ * A 32-bit timestamp fits in 'sival_int', so a queued signal can carry
+ * its own send time.  CLOCK_MONOTONIC is system-wide, so the receiver
+ * (usually another process) can compute the age of the stamp ---
+ * correctly as long as the age is below 2^32 ns (about 4.29 seconds);
+ * older stamps wrap around and would look younger than they are.
+ */
+static inline uint32_t
+ulat_stamp32 (void)
+{
+    return (uint32_t) ulat_now_ns();
+}
+
+static inline unsigned long long
+ulat_stamp32_age_ns (uint32_t stamp)
+{
+    return (uint32_t) ((uint32_t) ulat_now_ns() - stamp);
+}
+
+void  ulat_hist_reset(ulat_hist *lh);
+
+/*
+ * Only does arithmetic on the histogram object, so it is
+ * async-signal-safe as long as nobody else updates the same object
+ * at the same time.
+ */
+void  ulat_hist_add(ulat_hist *lh, unsigned long long value_ns);
+
+void  ulat_hist_merge(ulat_hist *dest, const ulat_hist *src);
+
+/*
+ * 'pct' is a percentage: 50.0 for the median, 99.9 for p999, etc.
+ * Returns zero for an empty histogram.
+ */
+unsigned long long  ulat_hist_percentile(const ulat_hist *lh, double pct);
+
+/*
+ * One line: count, min, p50, p90, p99, p99.9, max and mean ---
+ * shown in microseconds, since most of what we measure here
+ * is between a few hundred nanoseconds and a few milliseconds.
+ */
+void  ulat_show_hist(const ulat_hist *lh, const char *message_preamble,
+                     FILE *out_stream);
@@ -0,0 +1,119 @@
+/*
+ * play-utils/util-mem-range.c
+ *
+ * Utility module for ranges of anonymous memory managed by hand:
+ * reserved without access (PROT_NONE), then made accessible (committed),
+ * discarded and released in sub-ranges.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#define _DEFAULT_SOURCE  /* for MAP_ANONYMOUS, MAP_NORESERVE, madvise() */
+
+#include "util-mem-range.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+static errno_t
+report_ (const char *what, const umr_range *mr)
+{
+    const errno_t  err = errno;
+
+    fprintf(stderr, "%s(%p, %zu) failed: errno %d = %s\n",
+            what, mr->m_base_addr, mr->m_len, err, strerror(err));
+
+    return err;
+}
+
+
+size_t
+umr_page_size (void)
+{
+    static size_t  page_size = 0;
+
+    if (0 == page_size) {
+        page_size = (size_t) sysconf(_SC_PAGESIZE);
+    }
+
+    return page_size;
+}
+
+int
+umr_reserve (umr_range *mr, size_t len)
+{
+    void *addr;
+
+    mr->m_base_addr = NULL;
+    mr->m_len = umr_round_up(len, umr_page_size());
+
+    addr = mmap(NULL, mr->m_len, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (MAP_FAILED == addr) {
+        return report_("mmap", mr);
+    }
+    mr->m_base_addr = addr;
+
+    return 0;
+}
+
+void
+umr_subrange (umr_range *sub, const umr_range *mr, size_t offset, size_t len)
+{
+    sub->m_base_addr = (char *) mr->m_base_addr + offset;
+    sub->m_len = len;
+}
+
+int
+umr_protect (const umr_range *mr, int prot)
+{
+    if (mprotect(mr->m_base_addr, mr->m_len, prot) != 0) {
+        return report_("mprotect", mr);
+    }
+
+    return 0;
+}
+
+int
+umr_discard (const umr_range *mr)
+{
+    if (madvise(mr->m_base_addr, mr->m_len, MADV_DONTNEED) != 0) {
+        return report_("madvise(MADV_DONTNEED)", mr);
+    }
+
+    return 0;
+}
+
+int
+umr_release (umr_range *mr)
+{
+    if (munmap(mr->m_base_addr, mr->m_len) != 0) {
+        return report_("munmap", mr);
+    }
+    mr->m_base_addr = NULL;
+    mr->m_len = 0;
+
+    return 0;
+}
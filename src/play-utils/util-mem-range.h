@@ -0,0 +1,62 @@
+/*
+ * play-utils/util-mem-range.h
+ *
+ * Utility module for ranges of anonymous memory managed by hand:
+ * reserved without access (PROT_NONE), then made accessible (committed),
+ * discarded and released in sub-ranges.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#ifndef UTIL_MEM_RANGE_H
+#define UTIL_MEM_RANGE_H
+
+#include <stddef.h>
+
+
+typedef struct {
+    void   *m_base_addr;
+    size_t  m_len;
+} umr_range;
+
+
+/*
+ * sysconf(_SC_PAGESIZE), cached.
+ */
+size_t  umr_page_size(void);
+
+/*
+ * Rounds 'len' up to a multiple of 'unit' (a power of two).
+ */
+static inline size_t
+umr_round_up (size_t len, size_t unit)
+{
+    return (len + unit - 1) & ~(unit - 1);
+}
+
+/*
+ * 'len' bytes (rounded up to whole pages) of address space, PROT_NONE:
+ * no memory is committed and no swap is reserved (MAP_NORESERVE)
+ * until parts of it are made accessible with umr_protect().
+ * The functions below return 0, or an errno value (already reported).
+ */
+int  umr_reserve(umr_range *mr, size_t len);
+
+void  umr_subrange(umr_range *sub, const umr_range *mr, size_t offset, size_t len);
+
+int  umr_protect(const umr_range *mr, int prot);
+
+/*
+ * MADV_DONTNEED: the pages are dropped at once and read as zeroes
+ * the next time they are touched; the range stays mapped and accessible.
+ */
+int  umr_discard(const umr_range *mr);
+
+int  umr_release(umr_range *mr);
+
+#endif  /* UTIL_MEM_RANGE_H */
@@ -9,6 +9,7 @@
  *  if you want to)
  */
 
+#define _XOPEN_SOURCE 700  /* for the mutex protocols (__USE_UNIX98 in glibc) */
 #include "util-mutexattr.h"
 
 #include <assert.h>
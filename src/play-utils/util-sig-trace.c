@@ -0,0 +1,177 @@
+/*
+ * play-utils/util-sig-trace.c
+ *
+ * Utility module for tracing signals from their handlers:
+ * a preallocated, lock-free ring of small fixed-size events,
+ * appended by the handlers (async-signal-safe) and
+ * dumped later by a normal thread.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "util-sig-trace.h"
+
+#include <stdatomic.h>
+
+#include "util-latency.h"
+
+
+/*
+ * POSIX allows only lock-free atomics in signal handlers:
+ * a handler spinning on a lock held by the code it interrupted
+ * would spin forever.
+ */
+#if ATOMIC_LONG_LOCK_FREE != 2
+#  error "Need lock-free atomic longs for the handlers."
+#endif
+
+#define RING_MASK  (UST_RING_SIZE - 1)
+
+#define DUMP_BATCH  64
+
+
+/*
+ * A slot is published by storing its index + 1 in 'sl_seq', after
+ * the event; the reader takes it only if 'sl_seq' says so.
+ * Index + 1 because the slots start zeroed: slot 0 must not look
+ * published before the first event.
+ */
+typedef struct {
+    _Atomic unsigned long  sl_seq;
+
+    ust_event  sl_event;
+} slot_;
+
+static slot_  ring[UST_RING_SIZE];
+
+/*
+ * Both counters only grow; a slot is the counter masked.
+ * Handlers claim slots by moving 'ring_head' (compare-and-swap, not
+ * fetch-and-add: a claimed slot cannot be given back, so the check
+ * for a full ring and the claim must be one step); readers release them
+ * by moving 'ring_tail', after copying the event.
+ */
+static _Atomic unsigned long  ring_head = 0;
+static _Atomic unsigned long  ring_tail = 0;
+
+static _Atomic unsigned long  num_dropped = 0;
+
+/* For the dumps only. */
+static _Atomic unsigned long long  last_dumped_ns = 0;
+static _Atomic unsigned long  num_dropped_shown = 0;
+
+
+void
+ust_record (int signo, const siginfo_t *info)
+{
+    unsigned long  head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    slot_ *slot;
+
+    do {
+        if (head - atomic_load_explicit(&ring_tail, memory_order_acquire)
+            >= UST_RING_SIZE) {
+            atomic_fetch_add_explicit(&num_dropped, 1, memory_order_relaxed);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&ring_head, &head, head + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    slot = &ring[head & RING_MASK];
+
+    slot->sl_event.te_ns = ulat_now_ns();  /* clock_gettime(): async-signal-safe */
+    slot->sl_event.te_index = head;
+    slot->sl_event.te_signo = signo;
+    if (info != NULL) {
+        slot->sl_event.te_code = info->si_code;
+        slot->sl_event.te_pid = (long) info->si_pid;
+        slot->sl_event.te_value = info->si_value.sival_int;
+    } else {
+        slot->sl_event.te_code = 0;
+        slot->sl_event.te_pid = 0;
+        slot->sl_event.te_value = 0;
+    }
+
+    atomic_store_explicit(&slot->sl_seq, head + 1, memory_order_release);
+}
+
+size_t
+ust_drain (ust_event *out, size_t max_events)
+{
+    unsigned long  tail;
+    slot_ *slot;
+    size_t  n = 0;
+
+    while (n < max_events) {
+        tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+        slot = &ring[tail & RING_MASK];
+
+        if (atomic_load_explicit(&slot->sl_seq, memory_order_acquire) != tail + 1) {
+            break;  /* empty, or not published yet */
+        }
+        out[n] = slot->sl_event;
+
+        /*
+         * If another reader took the slot meanwhile, a handler may have
+         * reused it while we were copying: our copy is discarded.
+         */
+        if (atomic_compare_exchange_strong_explicit(&ring_tail, &tail, tail + 1,
+                                                    memory_order_release,
+                                                    memory_order_relaxed)) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+unsigned long
+ust_get_num_dropped (void)
+{
+    return atomic_load_explicit(&num_dropped, memory_order_relaxed);
+}
+
+void
+ust_dump (const char *message_preamble, FILE *out_stream)
+{
+    ust_event  events[DUMP_BATCH];
+
+    unsigned long long  now_ns;
+    unsigned long long  prev_ns;
+    unsigned long  dropped;
+    unsigned long  shown;
+    size_t  n;
+    size_t  ix;
+
+    while ((n = ust_drain(events, DUMP_BATCH)) > 0) {
+        now_ns = ulat_now_ns();
+        prev_ns = atomic_load_explicit(&last_dumped_ns, memory_order_relaxed);
+
+        for (ix = 0; ix < n; ++ix) {
+            fprintf(out_stream, "%s [trace %lu] signal %d: si_code=%d, si_pid=%ld,"
+                    " sival_int=%d; ",
+                    message_preamble, events[ix].te_index, events[ix].te_signo,
+                    events[ix].te_code, events[ix].te_pid, events[ix].te_value);
+            if (prev_ns != 0 && events[ix].te_ns >= prev_ns) {
+                fprintf(out_stream, "+%.3f usec, ",
+                        (double) (events[ix].te_ns - prev_ns) / 1e3);
+            }
+            fprintf(out_stream, "waited %.3f usec.\n",
+                    (double) (now_ns - events[ix].te_ns) / 1e3);
+            prev_ns = events[ix].te_ns;
+        }
+
+        atomic_store_explicit(&last_dumped_ns, prev_ns, memory_order_relaxed);
+    }
+
+    dropped = ust_get_num_dropped();
+    shown = atomic_exchange_explicit(&num_dropped_shown, dropped, memory_order_relaxed);
+    if (dropped != shown) {
+        fprintf(out_stream, "%s [trace] %lu events dropped (ring full), %lu in total.\n",
+                message_preamble, dropped - shown, dropped);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * play-utils/util-sig-trace.h
+ *
+ * Utility module for tracing signals from their handlers:
+ * a preallocated, lock-free ring of small fixed-size events,
+ * appended by the handlers (async-signal-safe) and
+ * dumped later by a normal thread.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+
+
+/*
+ * Events in the ring (a power of two); static storage, 48 bytes each.
+ * When the ring is full the new events are dropped and counted:
+ * a handler cannot wait for the reader.
+ */
+#define UST_RING_SIZE  8192
+
+
+typedef struct {
+    unsigned long long  te_ns;     /* CLOCK_MONOTONIC, see ulat_now_ns() */
+    unsigned long       te_index;  /* order of arrival, from 0; no gaps */
+
+    long  te_pid;    /* si_pid */
+    int   te_signo;
+    int   te_code;   /* si_code; 0 if the handler got no siginfo */
+    int   te_value;  /* si_value.sival_int */
+} ust_event;
+
+
+/*
+ * Async-signal-safe; may be called concurrently from handlers running
+ * in several threads, or nested in the same thread.
+ * 'info' may be NULL (handlers registered without SA_SIGINFO).
+ */
+void  ust_record(int signo, const siginfo_t *info);
+
+/*
+ * Moves up to 'max_events' events, oldest first, to 'out'.
+ * Stops early at an event whose handler is still filling it in
+ * (it was interrupted, or runs in another thread).
+ * NOT async-signal-safe; safe with several readers, though
+ * each gets only some of the events.
+ * Returns the number of events moved.
+ */
+size_t  ust_drain(ust_event *out, size_t max_events);
+
+unsigned long  ust_get_num_dropped(void);
+
+/*
+ * Drains the ring, showing one line per event: the time since
+ * the previous event, and how long the event waited in the ring.
+ * Also shows the number of events dropped since the last dump, if any.
+ */
+void  ust_dump(const char *message_preamble, FILE *out_stream);
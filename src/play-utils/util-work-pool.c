@@ -0,0 +1,589 @@
+/*
+ * play-utils/util-work-pool.c
+ *
+ * Utility module for a persistent pool of worker threads with
+ * work-stealing.
+ *
+ * The deques follow "Correct and Efficient Work-Stealing for
+ * Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli; PPoPP 2013),
+ * with a fixed-size circular array instead of a growable one.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include "util-work-pool.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * https://www.securecoding.cert.org/confluence/display/seccode/DCL09-C.+Declare+functions+that+return+errno+with+a+return+type+of+errno_t
+ *
+ * C11 Annex K introduced the new type 'errno_t' that
+ * is defined to be type 'int' in 'errno.h' and elsewhere.
+ * Many of the functions defined in C11 Annex K return values of this type.
+ * The 'errno_t' type should be used as the type of an object that
+ * may contain _only_ values that might be found in 'errno'.
+ */
+#ifndef __STDC_LIB_EXT1__
+    typedef  int  errno_t;
+#endif
+
+
+#define UWP_CACHE_LINE  64
+
+
+typedef struct uwp_task {
+    uwp_task_func  ut_func;
+    void          *ut_arg;
+
+    struct uwp_task *ut_next;  /* in the injection queue */
+} uwp_task;
+
+typedef struct {
+    /* The owner pushes and takes at the bottom, thieves steal at the top;
+     * on different cache lines, so thieves do not slow down the owner.
+     */
+    alignas(UWP_CACHE_LINE) atomic_long  dq_top;
+    alignas(UWP_CACHE_LINE) atomic_long  dq_bottom;
+
+    _Atomic(uwp_task *)  dq_buf[UWP_DEQUE_SIZE];
+} uwp_deque;
+
+typedef struct {
+    uwp_deque  uw_deque;
+
+    /* Updated only by the worker itself: */
+    alignas(UWP_CACHE_LINE) unsigned long  uw_n_own;
+    unsigned long  uw_n_injected;
+    unsigned long  uw_n_stolen;
+    unsigned long  uw_n_steal_aborts;
+    unsigned long  uw_n_parks;
+
+    unsigned int   uw_rand_state;  /* for choosing victims */
+
+    int  uw_index;
+
+    uwp_pool  *uw_pool;
+    pthread_t  uw_tid;
+} uwp_worker;
+
+struct uwp_pool {
+    /* Protects the injection queue, 'up_stopping', and the parking: */
+    pthread_mutex_t  up_mutex;
+    pthread_cond_t   up_work_cond;
+    pthread_cond_t   up_idle_cond;
+
+    uwp_task  *up_inj_head;
+    uwp_task  *up_inj_tail;
+
+    int  up_stopping;
+
+    alignas(UWP_CACHE_LINE) atomic_int   up_n_parked;
+    alignas(UWP_CACHE_LINE) atomic_long  up_n_pending;  /* submitted, not finished */
+
+    int  up_n_workers;
+    int  up_n_started;
+
+    uwp_worker *up_workers[UWP_WORKERS_MAX];
+};
+
+
+static _Thread_local uwp_worker *current_worker = NULL;
+
+
+/*
+ * Deque operations.
+ */
+
+static int
+deque_push_ (uwp_deque *dq, uwp_task *task)
+{
+    const long  b = atomic_load_explicit(&dq->dq_bottom, memory_order_relaxed);
+    const long  t = atomic_load_explicit(&dq->dq_top, memory_order_acquire);
+
+    if (b - t > UWP_DEQUE_SIZE - 1) {
+        return -1;  /* full */
+    }
+
+    atomic_store_explicit(&dq->dq_buf[b & (UWP_DEQUE_SIZE - 1)], task,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&dq->dq_bottom, b + 1, memory_order_relaxed);
+
+    return 0;
+}
+
+static uwp_task *
+deque_take_ (uwp_deque *dq)
+{
+    const long  b = atomic_load_explicit(&dq->dq_bottom, memory_order_relaxed) - 1;
+    long        t;
+
+    uwp_task *task = NULL;
+
+    atomic_store_explicit(&dq->dq_bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&dq->dq_top, memory_order_relaxed);
+
+    if (t <= b) {
+        task = atomic_load_explicit(&dq->dq_buf[b & (UWP_DEQUE_SIZE - 1)],
+                                    memory_order_relaxed);
+        if (t == b) {
+            /* The last one: race against the thieves for it. */
+            if (!atomic_compare_exchange_strong_explicit(&dq->dq_top, &t, t + 1,
+                                                         memory_order_seq_cst,
+                                                         memory_order_relaxed)) {
+                task = NULL;
+            }
+            atomic_store_explicit(&dq->dq_bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&dq->dq_bottom, b + 1, memory_order_relaxed);
+    }
+
+    return task;
+}
+
+/*
+ * Returns NULL if the deque is empty;
+ * sets '*aborted' if another thread won the race for the top task.
+ */
+static uwp_task *
+deque_steal_ (uwp_deque *dq, int *aborted)
+{
+    long  t = atomic_load_explicit(&dq->dq_top, memory_order_acquire);
+    long  b;
+
+    uwp_task *task = NULL;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&dq->dq_bottom, memory_order_acquire);
+
+    if (t < b) {
+        task = atomic_load_explicit(&dq->dq_buf[t & (UWP_DEQUE_SIZE - 1)],
+                                    memory_order_relaxed);
+        if (!atomic_compare_exchange_strong_explicit(&dq->dq_top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            *aborted = 1;
+            return NULL;
+        }
+    }
+
+    return task;
+}
+
+static int
+deque_looks_empty_ (uwp_deque *dq)
+{
+    const long  t = atomic_load_explicit(&dq->dq_top, memory_order_seq_cst);
+    const long  b = atomic_load_explicit(&dq->dq_bottom, memory_order_seq_cst);
+
+    return b <= t;
+}
+
+
+/*
+ * Injection queue; the pool mutex must be held.
+ */
+
+static void
+inject_locked_ (uwp_pool *pool, uwp_task *task)
+{
+    task->ut_next = NULL;
+    if (NULL == pool->up_inj_tail) {
+        pool->up_inj_head = task;
+    } else {
+        pool->up_inj_tail->ut_next = task;
+    }
+    pool->up_inj_tail = task;
+}
+
+static uwp_task *
+take_injected_locked_ (uwp_pool *pool)
+{
+    uwp_task *const task = pool->up_inj_head;
+
+    if (task != NULL) {
+        pool->up_inj_head = task->ut_next;
+        if (NULL == pool->up_inj_head) {
+            pool->up_inj_tail = NULL;
+        }
+    }
+
+    return task;
+}
+
+
+static void
+wake_one_if_parked_ (uwp_pool *pool)
+{
+    /* Pairs with the increment of 'up_n_parked' followed by
+     * the emptiness checks, in find_task_or_park_():
+     * either we see the parked worker, or it sees our task.
+     */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&pool->up_n_parked, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&pool->up_mutex);
+        pthread_cond_signal(&pool->up_work_cond);
+        pthread_mutex_unlock(&pool->up_mutex);
+    }
+}
+
+static unsigned int
+next_rand_ (uwp_worker *w)
+{
+    /* xorshift32 */
+    unsigned int  x = w->uw_rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    w->uw_rand_state = x;
+
+    return x;
+}
+
+static uwp_task *
+try_steal_ (uwp_worker *w)
+{
+    uwp_pool *const pool = w->uw_pool;
+    const int       n = pool->up_n_workers;
+
+    uwp_task *task;
+
+    int  start;
+    int  i;
+    int  aborted;
+
+    if (n < 2) {
+        return NULL;
+    }
+
+    do {
+        aborted = 0;
+        start = (int) (next_rand_(w) % (unsigned int) n);
+
+        for (i = 0; i < n; ++i) {
+            const int  victim = (start + i) % n;
+
+            if (victim == w->uw_index) {
+                continue;
+            }
+            task = deque_steal_(&pool->up_workers[victim]->uw_deque, &aborted);
+            if (task != NULL) {
+                ++w->uw_n_stolen;
+                return task;
+            }
+        }
+
+        if (aborted) {
+            ++w->uw_n_steal_aborts;
+        }
+    } while (aborted);  /* lost a race: there was work, look again */
+
+    return NULL;
+}
+
+static int
+all_deques_look_empty_ (uwp_pool *pool)
+{
+    int  i;
+
+    for (i = 0; i < pool->up_n_workers; ++i) {
+        if (!deque_looks_empty_(&pool->up_workers[i]->uw_deque)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Returns NULL only when the pool is stopping.
+ */
+static uwp_task *
+find_task_or_park_ (uwp_worker *w)
+{
+    uwp_pool *const pool = w->uw_pool;
+
+    uwp_task *task;
+
+    for (;;) {
+        task = deque_take_(&w->uw_deque);
+        if (task != NULL) {
+            ++w->uw_n_own;
+            return task;
+        }
+
+        pthread_mutex_lock(&pool->up_mutex);
+        task = take_injected_locked_(pool);
+        pthread_mutex_unlock(&pool->up_mutex);
+        if (task != NULL) {
+            ++w->uw_n_injected;
+            return task;
+        }
+
+        task = try_steal_(w);
+        if (task != NULL) {
+            return task;
+        }
+
+        pthread_mutex_lock(&pool->up_mutex);
+
+        atomic_fetch_add_explicit(&pool->up_n_parked, 1, memory_order_seq_cst);
+
+        /* Check again, now that submitters can see us parked: */
+        if (NULL == pool->up_inj_head && all_deques_look_empty_(pool)
+            && !pool->up_stopping) {
+            ++w->uw_n_parks;
+            pthread_cond_wait(&pool->up_work_cond, &pool->up_mutex);
+        }
+
+        atomic_fetch_sub_explicit(&pool->up_n_parked, 1, memory_order_relaxed);
+
+        if (pool->up_stopping && NULL == pool->up_inj_head) {
+            pthread_mutex_unlock(&pool->up_mutex);
+            return NULL;
+        }
+
+        pthread_mutex_unlock(&pool->up_mutex);
+    }
+}
+
+static void
+task_done_ (uwp_pool *pool)
+{
+    if (1 == atomic_fetch_sub_explicit(&pool->up_n_pending, 1, memory_order_acq_rel)) {
+        pthread_mutex_lock(&pool->up_mutex);
+        pthread_cond_broadcast(&pool->up_idle_cond);
+        pthread_mutex_unlock(&pool->up_mutex);
+    }
+}
+
+static void *
+worker_func_ (void *arg)
+{
+    uwp_worker *const w = arg;
+
+    uwp_task *task;
+
+    current_worker = w;
+
+    while ((task = find_task_or_park_(w)) != NULL) {
+        task->ut_func(task->ut_arg);
+        free(task);
+
+        task_done_(w->uw_pool);
+    }
+
+    current_worker = NULL;
+
+    return w;
+}
+
+
+int
+uwp_submit (uwp_pool *pool, uwp_task_func func, void *arg)
+{
+    uwp_worker *const w = current_worker;
+
+    uwp_task *const task = malloc(sizeof *task);
+
+    if (NULL == task) {
+        return ENOMEM;
+    }
+
+    task->ut_func = func;
+    task->ut_arg = arg;
+    task->ut_next = NULL;
+
+    atomic_fetch_add_explicit(&pool->up_n_pending, 1, memory_order_relaxed);
+
+    if (w != NULL && w->uw_pool == pool
+        && 0 == deque_push_(&w->uw_deque, task)) {
+        wake_one_if_parked_(pool);
+        return 0;
+    }
+
+    pthread_mutex_lock(&pool->up_mutex);
+    inject_locked_(pool, task);
+    if (atomic_load_explicit(&pool->up_n_parked, memory_order_relaxed) > 0) {
+        pthread_cond_signal(&pool->up_work_cond);
+    }
+    pthread_mutex_unlock(&pool->up_mutex);
+
+    return 0;
+}
+
+void
+uwp_wait_idle (uwp_pool *pool)
+{
+    pthread_mutex_lock(&pool->up_mutex);
+    while (atomic_load_explicit(&pool->up_n_pending, memory_order_acquire) > 0) {
+        pthread_cond_wait(&pool->up_idle_cond, &pool->up_mutex);
+    }
+    pthread_mutex_unlock(&pool->up_mutex);
+}
+
+
+static void
+stop_workers_ (uwp_pool *pool)
+{
+    errno_t  tjoin_res;
+
+    int  i;
+
+    pthread_mutex_lock(&pool->up_mutex);
+    pool->up_stopping = 1;
+    pthread_cond_broadcast(&pool->up_work_cond);
+    pthread_mutex_unlock(&pool->up_mutex);
+
+    for (i = 0; i < pool->up_n_started; ++i) {
+        tjoin_res = pthread_join(pool->up_workers[i]->uw_tid, NULL);
+        if (tjoin_res != 0) {
+            fprintf(stderr, "pthread_join(worker %d) failed, returning the errno value %d = %s\n",
+                    i, tjoin_res, strerror(tjoin_res));
+        }
+    }
+}
+
+static void
+free_pool_ (uwp_pool *pool)
+{
+    int  i;
+
+    for (i = 0; i < pool->up_n_workers; ++i) {
+        free(pool->up_workers[i]);
+    }
+
+    pthread_cond_destroy(&pool->up_idle_cond);
+    pthread_cond_destroy(&pool->up_work_cond);
+    pthread_mutex_destroy(&pool->up_mutex);
+
+    free(pool);
+}
+
+uwp_pool *
+uwp_create (int n_workers)
+{
+    uwp_pool *pool;
+
+    void    *mem;
+    errno_t  res;
+
+    int  i;
+
+    if (n_workers < 1 || n_workers > UWP_WORKERS_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    pool = calloc(1, sizeof *pool);
+    if (NULL == pool) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->up_mutex, NULL);
+    pthread_cond_init(&pool->up_work_cond, NULL);
+    pthread_cond_init(&pool->up_idle_cond, NULL);
+    atomic_init(&pool->up_n_parked, 0);
+    atomic_init(&pool->up_n_pending, 0);
+
+    pool->up_n_workers = n_workers;
+
+    for (i = 0; i < n_workers; ++i) {
+        res = posix_memalign(&mem, UWP_CACHE_LINE, sizeof (uwp_worker));
+        if (res != 0) {
+            pool->up_n_workers = i;
+            free_pool_(pool);
+            errno = res;
+            return NULL;
+        }
+        memset(mem, 0, sizeof (uwp_worker));
+        pool->up_workers[i] = mem;
+
+        pool->up_workers[i]->uw_index = i;
+        pool->up_workers[i]->uw_pool = pool;
+        pool->up_workers[i]->uw_rand_state = 2463534242u + (unsigned int) i * 7919u;
+        atomic_init(&pool->up_workers[i]->uw_deque.dq_top, 0);
+        atomic_init(&pool->up_workers[i]->uw_deque.dq_bottom, 0);
+    }
+
+    /* All the workers must exist before any can try to steal. */
+    for (i = 0; i < n_workers; ++i) {
+        res = pthread_create(&pool->up_workers[i]->uw_tid, NULL,
+                             &worker_func_, pool->up_workers[i]);
+        if (res != 0) {
+            stop_workers_(pool);
+            free_pool_(pool);
+            errno = res;
+            return NULL;
+        }
+        ++pool->up_n_started;
+    }
+
+    return pool;
+}
+
+void
+uwp_destroy (uwp_pool *pool)
+{
+    uwp_wait_idle(pool);
+    stop_workers_(pool);
+    free_pool_(pool);
+}
+
+int
+uwp_get_n_workers (const uwp_pool *pool)
+{
+    return pool->up_n_workers;
+}
+
+int
+uwp_current_worker (void)
+{
+    return (current_worker != NULL) ? current_worker->uw_index : -1;
+}
+
+void
+uwp_show_stats (const uwp_pool *pool, const char *preamble, FILE *out_stream)
+{
+    const uwp_worker *w;
+
+    unsigned long  total_tasks = 0;
+    unsigned long  total_stolen = 0;
+
+    int  i;
+
+    fprintf(out_stream, "%s %d workers:\n", preamble, pool->up_n_workers);
+
+    for (i = 0; i < pool->up_n_workers; ++i) {
+        w = pool->up_workers[i];
+
+        fprintf(out_stream, "%s  [%d] %lu tasks: %lu own, %lu injected, %lu stolen"
+                " (%lu steal races lost); parked %lu times\n",
+                preamble, i, w->uw_n_own + w->uw_n_injected + w->uw_n_stolen,
+                w->uw_n_own, w->uw_n_injected, w->uw_n_stolen,
+                w->uw_n_steal_aborts, w->uw_n_parks);
+
+        total_tasks += w->uw_n_own + w->uw_n_injected + w->uw_n_stolen;
+        total_stolen += w->uw_n_stolen;
+    }
+
+    fprintf(out_stream, "%s  (all) %lu tasks, %lu stolen\n",
+            preamble, total_tasks, total_stolen);
+}
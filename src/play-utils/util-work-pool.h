@@ -0,0 +1,73 @@
+/*
+ * play-utils/util-work-pool.h
+ *
+ * Utility module for a persistent pool of worker threads with
+ * work-stealing: each worker has a Chase-Lev deque of its own,
+ * tasks submitted from outside the pool go to a global injection queue,
+ * and idle workers park on a condition variable.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (c) 2026 Alexandru Nedel
+ *
+ * (add your name here when you make significant changes to this file,
+ *  if you want to)
+ */
+
+#include <stdio.h>
+
+
+/*
+ * Capacity of each worker's deque (a power of two).
+ * When its deque is full, a worker submits to the injection queue instead.
+ */
+#define UWP_DEQUE_SIZE  1024
+
+#define UWP_WORKERS_MAX  256
+
+
+typedef struct uwp_pool  uwp_pool;  /* opaque */
+
+typedef void  (*uwp_task_func)(void *arg);
+
+
+/*
+ * Starts 'n_workers' worker threads, with the signal mask of the caller.
+ * Returns NULL on failure, with 'errno' set.
+ */
+uwp_pool *  uwp_create(int n_workers);
+
+/*
+ * Can be called from any thread, including from a task running in the pool:
+ * a worker pushes onto its own deque (cheap, no lock), where other workers
+ * can steal from; any other thread appends to the injection queue.
+ *
+ * Returns 0 on success, or an errno value (ENOMEM).
+ */
+int   uwp_submit(uwp_pool *pool, uwp_task_func func, void *arg);
+
+/*
+ * Blocks until every task submitted so far (and every task these submitted)
+ * has finished.  Must not be called from a task.
+ */
+void  uwp_wait_idle(uwp_pool *pool);
+
+/*
+ * Waits for the pool to become idle, then stops and joins the workers.
+ */
+void  uwp_destroy(uwp_pool *pool);
+
+int   uwp_get_n_workers(const uwp_pool *pool);
+
+/*
+ * Index of the calling worker thread, or -1 if the caller is not
+ * a worker of any pool.
+ */
+int   uwp_current_worker(void);
+
+/*
+ * Per-worker statistics: tasks executed, where they were taken from
+ * (own deque, injection queue, stolen), and how many times it parked.
+ * Meaningful when the pool is idle (after uwp_wait_idle()).
+ */
+void  uwp_show_stats(const uwp_pool *pool, const char *preamble, FILE *out_stream);